@@ -188,6 +188,7 @@ void do_init(void *o)
 	initializeManifestProcessor();
 	debug_log_init();
 	spim_irq_init();
+	init_flash_dev_table();
 
 #if defined(CONFIG_SPI_DMA_SUPPORT_ASPEED) || defined(CONFIG_SPI_WRITE_DMA_SUPPORT_ASPEED)
 	init_flash_rw_buf_mutex();
@@ -868,6 +869,11 @@ void do_rot_recovery(void *o)
 
 	clear_abr_indicator();
 
+#if defined(CONFIG_PFR_SPI_DIFF_COPY)
+	LOG_INF("Copy PFR Recovery region to Active region, skipping identical sectors");
+	status = pfr_spi_region_diff_copy(ROT_INTERNAL_RECOVERY, 0,
+			ROT_INTERNAL_ACTIVE, 0, region_size, NULL);
+#else
 	LOG_INF("Erase PFR Active region size=%08x", region_size);
 	if (pfr_spi_erase_region(ROT_INTERNAL_ACTIVE, true, 0, region_size)) {
 		LOG_ERR("Erase PFR active region failed, SYSTEM LOCKDOWN");
@@ -877,6 +883,7 @@ void do_rot_recovery(void *o)
 	LOG_INF("Copy PFR Recovery region to Active region");
 	status = pfr_spi_region_read_write_between_spi(ROT_INTERNAL_RECOVERY, 0,
 			ROT_INTERNAL_ACTIVE, 0, region_size);
+#endif
 
 	if (!status) {
 		LOG_INF("Copy PFR Recovery region to Active region done");
@@ -1092,9 +1099,11 @@ void handle_provision_image(void *o)
 
 	const struct device *dev_m = device_get_binding(BMC_SPI_MONITOR);
 	spim_ext_mux_config(dev_m, SPIM_EXT_MUX_ROT);
+	flash_write_generation_bump(BMC_SPI);
 #if defined(CONFIG_BMC_DUAL_FLASH)
 	dev_m = device_get_binding(BMC_SPI_MONITOR_2);
 	spim_ext_mux_config(dev_m, SPIM_EXT_MUX_ROT);
+	flash_write_generation_bump(BMC_SPI);
 #endif
 	ret = update_firmware_image(image_type, ao_data_wrap, &evt_ctx_wrap, &cpld_update_status);
 
@@ -1104,9 +1113,11 @@ void handle_provision_image(void *o)
 
 	dev_m = device_get_binding(BMC_SPI_MONITOR);
 	spim_ext_mux_config(dev_m, SPIM_EXT_MUX_BMC_PCH);
+	flash_write_generation_bump(BMC_SPI);
 #if defined(CONFIG_BMC_DUAL_FLASH)
 	dev_m = device_get_binding(BMC_SPI_MONITOR_2);
 	spim_ext_mux_config(dev_m, SPIM_EXT_MUX_BMC_PCH);
+	flash_write_generation_bump(BMC_SPI);
 #endif
 
 	LOG_INF("Provision result = %d", ret);
@@ -1513,9 +1524,11 @@ void handle_seamless_update_verification(void *o)
 	LOG_INF("Switch PCH SPI MUX to ROT");
 	dev_m = device_get_binding(PCH_SPI_MONITOR);
 	spim_ext_mux_config(dev_m, SPIM_EXT_MUX_ROT);
+	flash_write_generation_bump(PCH_SPI);
 #if defined(CONFIG_CPU_DUAL_FLASH)
 	dev_m = device_get_binding(PCH_SPI_MONITOR_2);
 	spim_ext_mux_config(dev_m, SPIM_EXT_MUX_ROT);
+	flash_write_generation_bump(PCH_SPI);
 #endif
 
 	ret = authentication_image(NULL, &evt_wrap);
@@ -1536,9 +1549,11 @@ void handle_seamless_update_verification(void *o)
 	LOG_INF("Switch PCH SPI MUX to PCH");
 	dev_m = device_get_binding(PCH_SPI_MONITOR);
 	spim_ext_mux_config(dev_m, SPIM_EXT_MUX_BMC_PCH);
+	flash_write_generation_bump(PCH_SPI);
 #if defined(CONFIG_CPU_DUAL_FLASH)
 	dev_m = device_get_binding(PCH_SPI_MONITOR_2);
 	spim_ext_mux_config(dev_m, SPIM_EXT_MUX_BMC_PCH);
+	flash_write_generation_bump(PCH_SPI);
 #endif
 }
 #endif
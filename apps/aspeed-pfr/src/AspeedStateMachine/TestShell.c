@@ -195,11 +195,253 @@ static int cmd_asm_flash_rebind(const struct shell *shell, size_t argc,
 		return 0;
 	}
 
-	int ret = spi_nor_re_init(dev);
+	int ret = flash_re_init(dev);
 	shell_print(shell, "spi_nor_re_init(%s) return %d", argv[1], ret);
 	return 0;
 }
 
+#define FLASH_STRESS_STACK_SIZE 1024
+#define FLASH_STRESS_MAX_LENGTH 0x1000
+
+struct flash_stress_ctx {
+	uint8_t device_id;
+	uint32_t offset;
+	uint32_t length;
+	uint32_t loops;
+	uint8_t *ref;
+	uint32_t errors;
+	uint32_t mismatches;
+};
+
+K_THREAD_STACK_ARRAY_DEFINE(flash_stress_stacks, 2, FLASH_STRESS_STACK_SIZE);
+static struct k_thread flash_stress_threads[2];
+
+static void flash_stress_worker(void *a, void *b, void *c)
+{
+	struct flash_stress_ctx *ctx = a;
+	// Cached stack buffer, so every read is staged through the controller bounce buffer
+	uint8_t buffer[128];
+	uint32_t loop, pos, len;
+
+	ARG_UNUSED(b);
+	ARG_UNUSED(c);
+
+	for (loop = 0; loop < ctx->loops; loop++) {
+		for (pos = 0; pos < ctx->length; pos += len) {
+			len = MIN(sizeof(buffer), ctx->length - pos);
+			if (pfr_spi_read(ctx->device_id, ctx->offset + pos, len, buffer))
+				ctx->errors++;
+			else if (memcmp(buffer, ctx->ref + pos, len))
+				ctx->mismatches++;
+		}
+	}
+}
+
+static int cmd_asm_flash_stress(const struct shell *shell, size_t argc,
+			char **argv)
+{
+	struct flash_stress_ctx ctx[2];
+	uint32_t offset, length, loops;
+	uint32_t elapsed[2];
+	int64_t start;
+	k_tid_t tid;
+	int run, i;
+
+	if (argc < 6) {
+		shell_print(shell, "asm flash_stress DEVICE_ID_A DEVICE_ID_B OFFSET LENGTH LOOPS");
+		return 0;
+	}
+
+	offset = strtol(argv[3], NULL, 16);
+	length = strtol(argv[4], NULL, 16);
+	loops = strtol(argv[5], NULL, 10);
+	if (length == 0 || length > FLASH_STRESS_MAX_LENGTH) {
+		shell_print(shell, "LENGTH must be between 1 and %x", FLASH_STRESS_MAX_LENGTH);
+		return 0;
+	}
+
+	for (i = 0; i < 2; i++) {
+		ctx[i].device_id = strtol(argv[1 + i], NULL, 10);
+		ctx[i].offset = offset;
+		ctx[i].length = length;
+		ctx[i].loops = loops;
+		ctx[i].ref = k_malloc(length);
+		if (ctx[i].ref == NULL || pfr_spi_read(ctx[i].device_id, offset, length, ctx[i].ref)) {
+			shell_print(shell, "Failed to read reference data of device %d",
+					ctx[i].device_id);
+			k_free(ctx[0].ref);
+			if (i)
+				k_free(ctx[1].ref);
+			return 0;
+		}
+	}
+
+	// Run the two devices one after the other, then concurrently on two threads
+	for (run = 0; run < 2; run++) {
+		for (i = 0; i < 2; i++) {
+			ctx[i].errors = 0;
+			ctx[i].mismatches = 0;
+		}
+
+		start = k_uptime_get();
+		for (i = 0; i < 2; i++) {
+			tid = k_thread_create(&flash_stress_threads[i], flash_stress_stacks[i],
+					K_THREAD_STACK_SIZEOF(flash_stress_stacks[i]),
+					flash_stress_worker, &ctx[i], NULL, NULL,
+					K_PRIO_PREEMPT(5), 0, K_NO_WAIT);
+			if (run == 0)
+				k_thread_join(tid, K_FOREVER);
+		}
+		if (run == 1) {
+			for (i = 0; i < 2; i++)
+				k_thread_join(&flash_stress_threads[i], K_FOREVER);
+		}
+		elapsed[run] = (uint32_t)(k_uptime_get() - start);
+
+		for (i = 0; i < 2; i++)
+			shell_print(shell, "%s dev %d: %u read errors, %u mismatches",
+					run ? "concurrent" : "sequential", ctx[i].device_id,
+					ctx[i].errors, ctx[i].mismatches);
+	}
+
+	shell_print(shell, "sequential %u ms, concurrent %u ms", elapsed[0], elapsed[1]);
+	k_free(ctx[0].ref);
+	k_free(ctx[1].ref);
+
+	return 0;
+}
+
+struct erase_plan_case {
+	uint32_t addr;
+	uint32_t length;
+	uint8_t caps;
+	uint16_t ops_64k;
+	uint16_t ops_32k;
+	uint16_t ops_4k;
+};
+
+static const struct erase_plan_case erase_plan_cases[] = {
+	{ 0x00000, 0x10000, PFR_ERASE_CAP_64K | PFR_ERASE_CAP_32K, 1, 0, 0 },
+	{ 0x01000, 0x1f000, PFR_ERASE_CAP_64K | PFR_ERASE_CAP_32K, 1, 1, 7 },
+	{ 0x00000, 0x09000, PFR_ERASE_CAP_64K | PFR_ERASE_CAP_32K, 0, 1, 1 },
+	{ 0x03000, 0x02000, PFR_ERASE_CAP_64K | PFR_ERASE_CAP_32K, 0, 0, 2 },
+	{ 0x08000, 0x10000, PFR_ERASE_CAP_64K | PFR_ERASE_CAP_32K, 0, 2, 0 },
+	{ 0x08000, 0x10000, PFR_ERASE_CAP_64K, 0, 0, 16 },
+	{ 0x00000, 0x10000, PFR_ERASE_CAP_32K, 0, 2, 0 },
+	{ 0x00000, 0x10000, 0, 0, 0, 16 },
+	{ 0x10000, 0x30000, PFR_ERASE_CAP_64K | PFR_ERASE_CAP_32K, 3, 0, 0 },
+};
+
+/* Returns true if the plan tiles [addr, addr + length) with aligned erases of the expected mix */
+static bool erase_plan_check(const struct shell *shell, const struct erase_plan_case *tc)
+{
+	uint16_t ops_64k = 0, ops_32k = 0, ops_4k = 0;
+	uint32_t addr = tc->addr;
+	uint32_t end = tc->addr + tc->length;
+	uint32_t size;
+	uint8_t cmd;
+
+	while (addr < end) {
+		cmd = pfr_spi_erase_plan_next(addr, end, tc->caps, &size);
+		if (addr % size || size > end - addr) {
+			shell_print(shell, "  bad erase op %02x at %x size %x", cmd, addr, size);
+			return false;
+		}
+
+		if (cmd == MIDLEY_FLASH_CMD_BLOCK_ERASE && size == BLOCK_SIZE &&
+		    (tc->caps & PFR_ERASE_CAP_64K))
+			ops_64k++;
+		else if (cmd == MIDLEY_FLASH_CMD_32K_ERASE && size == BLOCK_32K_SIZE &&
+			 (tc->caps & PFR_ERASE_CAP_32K))
+			ops_32k++;
+		else if (cmd == MIDLEY_FLASH_CMD_4K_ERASE && size == SECTOR_SIZE)
+			ops_4k++;
+		else {
+			shell_print(shell, "  unexpected erase op %02x size %x", cmd, size);
+			return false;
+		}
+		addr += size;
+	}
+
+	if (ops_64k != tc->ops_64k || ops_32k != tc->ops_32k || ops_4k != tc->ops_4k) {
+		shell_print(shell, "  got 64K:%d 32K:%d 4K:%d", ops_64k, ops_32k, ops_4k);
+		return false;
+	}
+
+	return true;
+}
+
+static int cmd_asm_erase_plan_test(const struct shell *shell, size_t argc,
+			char **argv)
+{
+	const struct erase_plan_case *tc;
+	int failed = 0;
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(erase_plan_cases); i++) {
+		tc = &erase_plan_cases[i];
+		shell_print(shell, "%x+%x caps %x: expect 64K:%d 32K:%d 4K:%d",
+				tc->addr, tc->length, tc->caps, tc->ops_64k, tc->ops_32k,
+				tc->ops_4k);
+		if (!erase_plan_check(shell, tc))
+			failed++;
+	}
+
+	shell_print(shell, "Erase planner: %d of %d cases failed", failed,
+			(int)ARRAY_SIZE(erase_plan_cases));
+
+	return 0;
+}
+
+#if defined(CONFIG_FLASH_STATS)
+static const char * const flash_stats_op_name[FLASH_STATS_OP_COUNT] = {
+	"read",
+	"write",
+	"erase",
+};
+
+static int cmd_asm_flash_stats_dump(const struct shell *shell, size_t argc,
+			char **argv)
+{
+	struct flash_op_stats stats;
+	uint8_t device_id, op, bucket;
+
+	for (device_id = 0; device_id < FLASH_STATS_DEV_COUNT; device_id++) {
+		for (op = 0; op < FLASH_STATS_OP_COUNT; op++) {
+			if (flash_stats_get(device_id, op, &stats) || !stats.count)
+				continue;
+
+			shell_print(shell, "dev %2d %-5s ops %u err %u %u KB avg %u us max %u us",
+					device_id, flash_stats_op_name[op], stats.count, stats.errors,
+					(uint32_t)(stats.bytes >> 10),
+					(uint32_t)(stats.total_us / stats.count), stats.max_us);
+			for (bucket = 0; bucket < FLASH_STATS_HIST_BUCKETS; bucket++) {
+				if (stats.hist[bucket])
+					shell_print(shell, "    >= %8u us: %u",
+							(uint32_t)(bucket ? BIT(bucket) : 0), stats.hist[bucket]);
+			}
+		}
+	}
+
+	return 0;
+}
+
+static int cmd_asm_flash_stats_reset(const struct shell *shell, size_t argc,
+			char **argv)
+{
+	flash_stats_reset();
+	shell_print(shell, "Flash statistics cleared");
+
+	return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_flash_stats,
+	SHELL_CMD(dump, NULL, "Dump per device flash I/O statistics", cmd_asm_flash_stats_dump),
+	SHELL_CMD(reset, NULL, "Clear flash I/O statistics", cmd_asm_flash_stats_reset),
+	SHELL_SUBCMD_SET_END
+);
+#endif
+
 static int cmd_asm_rot_recovery(const struct shell *shell, size_t argc,
 			char **argv)
 {
@@ -269,6 +511,7 @@ static void inject_spi_error(const struct shell *shell, uint32_t flag)
 		const struct device *dev_mon = device_get_binding("spi_m1");
 		const struct device *dev_flash = device_get_binding("spi1_cs0");
 		spim_ext_mux_config(dev_mon, SPIM_EXT_MUX_ROT);
+		flash_write_generation_bump(BMC_SPI);
 		if (flag & 0x0F000000) {
 			/* ACT */
 			uint32_t address;
@@ -310,6 +553,7 @@ static void inject_spi_error(const struct shell *shell, uint32_t flag)
 					"spi1_cs0", address, 0x10000);
 		}
 		spim_ext_mux_config(dev_mon, SPIM_EXT_MUX_BMC_PCH);
+		flash_write_generation_bump(BMC_SPI);
 	}
 
 	if (flag & 0x00000FFF) {
@@ -317,6 +561,7 @@ static void inject_spi_error(const struct shell *shell, uint32_t flag)
 		const struct device *dev_mon = device_get_binding("spi_m3");
 		const struct device *dev_flash = device_get_binding("spi2_cs0");
 		spim_ext_mux_config(dev_mon, SPIM_EXT_MUX_ROT);
+		flash_write_generation_bump(PCH_SPI);
 		if (flag & 0x00000F00) {
 			/* ACT */
 			uint32_t address;
@@ -348,6 +593,7 @@ static void inject_spi_error(const struct shell *shell, uint32_t flag)
 					"spi2_cs0", address, 0x10000);
 		}
 		spim_ext_mux_config(dev_mon, SPIM_EXT_MUX_BMC_PCH);
+		flash_write_generation_bump(PCH_SPI);
 	}
 }
 
@@ -1093,6 +1339,13 @@ SHELL_STATIC_SUBCMD_SET_CREATE(sub_asm,
 	SHELL_CMD(flash_cmp, NULL, "Flash content compairson", cmd_asm_flash_cmp),
 	SHELL_CMD(flash_copy, NULL, "Copy data between Flash", cmd_asm_flash_copy),
 	SHELL_CMD(flash_rebind, NULL, "Rebind SPI Flash", cmd_asm_flash_rebind),
+	SHELL_CMD(erase_plan_test, NULL, "Check the erase planner against known plans",
+			cmd_asm_erase_plan_test),
+	SHELL_CMD(flash_stress, NULL, "Read two flash devices from two threads and check the data",
+			cmd_asm_flash_stress),
+#if defined(CONFIG_FLASH_STATS)
+	SHELL_CMD(flash_stats, &sub_flash_stats, "Flash I/O statistics: dump or reset", NULL),
+#endif
 	SHELL_CMD(pstate, NULL, "Test Platform State LED", cmd_test_plat_state_led),
 #if defined(CONFIG_INTEL_PFR)
 	SHELL_CMD(afm, NULL, "Dump AFM Structure: DEVICE OFFSET", cmd_afm),
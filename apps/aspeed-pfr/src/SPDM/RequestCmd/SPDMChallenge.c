@@ -68,8 +68,13 @@ int spdm_challenge(void *ctx, uint8_t slot_id, uint8_t measurements)
 	rsp_msg.buffer.write_ptr -= 96;
 	spdm_context_update_m1m2_hash(context, &req_msg, &rsp_msg);
 	rsp_msg.buffer.write_ptr += 96;
-	mbedtls_sha512_finish(&context->m1m2_context, hash);
+	ret = spdm_context_get_m1m2_hash(context, hash);
 	spdm_context_reset_m1m2_hash(context);
+	if (ret) {
+		LOG_ERR("CHALLENGE_AUTH M1M2 hash failed ret=%x", -ret);
+		ret = -1;
+		goto cleanup;
+	}
 
 	ret = spdm_crypto_verify(context, slot_id,
 			hash, 48,
@@ -89,12 +89,17 @@ int spdm_get_measurements(void *ctx,
 		/* Verify signature */
 		uint8_t hash[48];
 
-		mbedtls_sha512_finish(&context->l1l2_context, hash);
+		ret = spdm_context_get_l1l2_hash(context, hash);
 		spdm_context_reset_l1l2_hash(context);
 		if (req_msg.header.spdm_version == SPDM_VERSION_12) {
 			/* Append VCA to L1L2 for SPDM 1.2 */
 			spdm_context_update_l1l2_hash_buffer(context, &context->message_a);
 		}
+		if (ret) {
+			LOG_ERR("MEASUREMENTS L1L2 hash failed ret=%x", -ret);
+			ret = -2;
+			goto cleanup;
+		}
 
 		/* DSP0274_1.0.1: 
 		 * 310: Public key associated with the slot 0 certificate of the Responder.
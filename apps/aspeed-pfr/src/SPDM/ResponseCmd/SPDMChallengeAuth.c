@@ -101,8 +101,17 @@ int spdm_handle_challenge(void *ctx, void *req, void *rsp)
 
 	// Calculate HASH(M1)
 	spdm_context_update_m1m2_hash(context, req_msg, rsp_msg);
-	mbedtls_sha512_finish(&context->m1m2_context, hash);
+	ret = spdm_context_get_m1m2_hash(context, hash);
 	spdm_context_reset_m1m2_hash(context);
+	if (ret) {
+		LOG_ERR("CHALLENGE M1M2 hash failed ret=%x", -ret);
+		rsp_msg->header.request_response_code = SPDM_RSP_ERROR;
+		rsp_msg->header.param1 = SPDM_ERROR_CODE_UNSPECIFIED;
+		rsp_msg->header.param2 = 0;
+		spdm_buffer_release(&rsp_msg->buffer);
+		ret = -1;
+		goto cleanup;
+	}
 
 	ret = spdm_crypto_sign(context, hash, hash_length, sig, &sig_len,
 			req_msg->header.spdm_version == SPDM_VERSION_12,
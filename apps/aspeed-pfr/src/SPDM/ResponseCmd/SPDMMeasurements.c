@@ -119,7 +119,7 @@ int spdm_handle_get_measurements(void *ctx, void *req, void *rsp)
 		 */
 		uint8_t hash[48];
 
-		mbedtls_sha512_finish(&context->l1l2_context, hash);
+		ret = spdm_context_get_l1l2_hash(context, hash);
 		LOG_HEXDUMP_DBG(hash, 48, "L1L2 Hash");
 		LOG_HEXDUMP_DBG(context->message_a.data, context->message_a.write_ptr, "message_a");
 
@@ -127,6 +127,15 @@ int spdm_handle_get_measurements(void *ctx, void *req, void *rsp)
 		if (req_msg->header.spdm_version == SPDM_VERSION_12) {
 			spdm_context_update_l1l2_hash_buffer(context, &context->message_a);
 		}
+		if (ret) {
+			LOG_ERR("GET_MEASUREMENTS L1L2 hash failed ret=%x", -ret);
+			rsp_msg->header.request_response_code = SPDM_RSP_ERROR;
+			rsp_msg->header.param1 = SPDM_ERROR_CODE_UNSPECIFIED;
+			rsp_msg->header.param2 = 0;
+			spdm_buffer_release(&rsp_msg->buffer);
+			ret = -1;
+			goto cleanup;
+		}
 
 		/* Sign the message */
 		uint8_t sig[MBEDTLS_ECDSA_MAX_LEN];
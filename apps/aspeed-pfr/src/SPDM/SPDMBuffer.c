@@ -43,6 +43,9 @@ int spdm_buffer_resize(struct spdm_buffer *buffer, size_t size)
 	}
 
 	void *temp = malloc(size);
+	if (temp == NULL) {
+		return -1;
+	}
 	memset(temp, 0, size);
 	if (buffer->data != NULL && buffer->size > 0) {
 		memcpy(temp, buffer->data, MIN(size, buffer->size));
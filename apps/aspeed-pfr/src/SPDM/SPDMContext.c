@@ -7,6 +7,7 @@
 #include <random/rand32.h>
 #include <stdlib.h>
 #include "SPDM/SPDMCommon.h"
+#include "crypto/hash_aspeed.h"
 
 LOG_MODULE_DECLARE(spdm, CONFIG_LOG_DEFAULT_LEVEL);
 
@@ -18,6 +19,95 @@ int random_callback(void *context, unsigned char *output, size_t output_len)
 	return 0;
 }
 
+static void spdm_transcript_init(struct spdm_transcript_hash *transcript)
+{
+	spdm_buffer_init(&transcript->staged, 0);
+	mbedtls_sha512_init(&transcript->sw_ctx);
+	transcript->sw = !IS_ENABLED(CONFIG_PFR_SPDM_TRANSCRIPT_HW);
+	transcript->status = 0;
+	if (transcript->sw)
+		transcript->status = mbedtls_sha512_starts(&transcript->sw_ctx, /* is384 */ 1);
+}
+
+static void spdm_transcript_release(struct spdm_transcript_hash *transcript)
+{
+	spdm_buffer_release(&transcript->staged);
+	mbedtls_sha512_free(&transcript->sw_ctx);
+}
+
+static void spdm_transcript_reset(struct spdm_transcript_hash *transcript)
+{
+	transcript->staged.write_ptr = 0;
+	mbedtls_sha512_free(&transcript->sw_ctx);
+	mbedtls_sha512_init(&transcript->sw_ctx);
+	transcript->sw = !IS_ENABLED(CONFIG_PFR_SPDM_TRANSCRIPT_HW);
+	transcript->status = 0;
+	if (transcript->sw)
+		transcript->status = mbedtls_sha512_starts(&transcript->sw_ctx, /* is384 */ 1);
+}
+
+/* A failed update leaves the transcript incomplete, the error sticks until the next reset so
+ * that the digest is never computed over a partial transcript.
+ */
+static int spdm_transcript_update(struct spdm_transcript_hash *transcript,
+		const void *data, size_t length)
+{
+	if (transcript->status)
+		return transcript->status;
+
+#if defined(CONFIG_PFR_SPDM_TRANSCRIPT_HW)
+	struct spdm_buffer *staged = &transcript->staged;
+	size_t needed = staged->write_ptr + length;
+
+	if (!transcript->sw) {
+		if (needed <= CONFIG_PFR_SPDM_TRANSCRIPT_HW_MAX &&
+		    (needed <= staged->size ||
+		     spdm_buffer_resize(staged, MIN(MAX(needed, staged->size * 2),
+					CONFIG_PFR_SPDM_TRANSCRIPT_HW_MAX)) == 0)) {
+			transcript->status = spdm_buffer_append_array(staged, (void *)data, length);
+			return transcript->status;
+		}
+
+		// Transcript outgrew the staging buffer or it could not grow, continue in software
+		transcript->status = mbedtls_sha512_starts(&transcript->sw_ctx, /* is384 */ 1);
+		if (transcript->status == 0)
+			transcript->status = mbedtls_sha512_update(&transcript->sw_ctx,
+					staged->data, staged->write_ptr);
+		staged->write_ptr = 0;
+		transcript->sw = true;
+		if (transcript->status)
+			return transcript->status;
+	}
+#endif
+	transcript->status = mbedtls_sha512_update(&transcript->sw_ctx, data, length);
+
+	return transcript->status;
+}
+
+/* Digest of the transcript so far, the transcript itself is left untouched */
+static int spdm_transcript_digest(struct spdm_transcript_hash *transcript, uint8_t *hash)
+{
+	mbedtls_sha512_context clone;
+	int ret;
+
+	if (transcript->status) {
+		LOG_ERR("Transcript is incomplete (%d)", transcript->status);
+		return transcript->status;
+	}
+
+#if defined(CONFIG_PFR_SPDM_TRANSCRIPT_HW)
+	if (!transcript->sw)
+		return hash_engine_sha_calculate(HASH_SHA384, transcript->staged.data,
+				transcript->staged.write_ptr, hash, 48);
+#endif
+	mbedtls_sha512_init(&clone);
+	mbedtls_sha512_clone(&clone, &transcript->sw_ctx);
+	ret = mbedtls_sha512_finish(&clone, hash);
+	mbedtls_sha512_free(&clone);
+
+	return ret;
+}
+
 void *spdm_context_create()
 {
 	struct spdm_context *context = (struct spdm_context *)malloc(sizeof(struct spdm_context));
@@ -74,12 +164,9 @@ void *spdm_context_create()
 #if defined(SPDM_TRANSCRIPT)
 	spdm_buffer_init(&context->message_b, 0);
 	spdm_buffer_init(&context->message_c, 0);
-#else
-	spdm_context_reset_m1m2_hash(context);
 #endif
-
-	mbedtls_sha512_init(&context->l1l2_context);
-	mbedtls_sha512_starts(&context->l1l2_context, /* is384 */ 1);
+	spdm_transcript_init(&context->m1m2_context);
+	spdm_transcript_init(&context->l1l2_context);
 
 	mbedtls_ecp_keypair_init(&context->key_pair);
 
@@ -112,12 +199,10 @@ void spdm_context_release(void *ctx)
 #if defined(SPDM_TRANSCRIPT)
 	spdm_buffer_release(&context->message_b);
 	spdm_buffer_release(&context->message_c);
-#else
-	/* TODO: Assuming the hash algorithm is SHA384 */
-	mbedtls_sha512_free(&context->m1m2_context);
 #endif
 	/* TODO: Assuming the hash algorithm is SHA384 */
-	mbedtls_sha512_free(&context->l1l2_context);
+	spdm_transcript_release(&context->m1m2_context);
+	spdm_transcript_release(&context->l1l2_context);
 	if (context->release_connection_data)
 		context->release_connection_data(context);
 	free(context);
@@ -225,12 +310,17 @@ void spdm_context_reset_m1m2_hash(void *ctx)
 {
 	struct spdm_context *context = (struct spdm_context *)ctx;
 
-	mbedtls_sha512_free(&context->m1m2_context);
-	mbedtls_sha512_init(&context->m1m2_context);
-	mbedtls_sha512_starts(&context->m1m2_context, /* is384 */ 1);
+	spdm_transcript_reset(&context->m1m2_context);
+}
+
+int spdm_context_get_m1m2_hash(void *ctx, uint8_t *hash)
+{
+	struct spdm_context *context = (struct spdm_context *)ctx;
+
+	return spdm_transcript_digest(&context->m1m2_context, hash);
 }
 
-void spdm_context_update_m1m2_hash(void *ctx, void *req, void *rsp)
+int spdm_context_update_m1m2_hash(void *ctx, void *req, void *rsp)
 {
 	struct spdm_context *context = (struct spdm_context *)ctx;
 	struct spdm_message *req_msg = (struct spdm_message *)req;
@@ -240,41 +330,48 @@ void spdm_context_update_m1m2_hash(void *ctx, void *req, void *rsp)
 	LOG_HEXDUMP_DBG((const unsigned char *)req_msg->buffer.data, req_msg->buffer.write_ptr, "M1M2 Append REQ Payload");
 	LOG_HEXDUMP_DBG((const unsigned char *)&rsp_msg->header, sizeof(rsp_msg->header), "M1M2 Append RSP Header");
 	LOG_HEXDUMP_DBG((const unsigned char *)rsp_msg->buffer.data, rsp_msg->buffer.write_ptr, "M1M2 Append RSP Payload");
-	mbedtls_sha512_update(&context->m1m2_context,
+	spdm_transcript_update(&context->m1m2_context,
 			(const unsigned char *)&req_msg->header,
 			sizeof(req_msg->header));
-	mbedtls_sha512_update(&context->m1m2_context,
+	spdm_transcript_update(&context->m1m2_context,
 			(const unsigned char *)req_msg->buffer.data,
 			req_msg->buffer.write_ptr);
-	mbedtls_sha512_update(&context->m1m2_context,
+	spdm_transcript_update(&context->m1m2_context,
 			(const unsigned char *)&rsp_msg->header,
 			sizeof(rsp_msg->header));
-	mbedtls_sha512_update(&context->m1m2_context,
+	spdm_transcript_update(&context->m1m2_context,
 			(const unsigned char *)rsp_msg->buffer.data,
 			rsp_msg->buffer.write_ptr);
+
+	return context->m1m2_context.status;
 }
 
 void spdm_context_reset_l1l2_hash(void *ctx)
 {
 	struct spdm_context *context = (struct spdm_context *)ctx;
 
-	mbedtls_sha512_free(&context->l1l2_context);
-	mbedtls_sha512_init(&context->l1l2_context);
-	mbedtls_sha512_starts(&context->l1l2_context, /* is384 */ 1);
+	spdm_transcript_reset(&context->l1l2_context);
 
 	LOG_DBG("RESET L1L2 BUFFER");
 }
 
-void spdm_context_update_l1l2_hash_buffer(void *ctx, void *buf)
+int spdm_context_get_l1l2_hash(void *ctx, uint8_t *hash)
+{
+	struct spdm_context *context = (struct spdm_context *)ctx;
+
+	return spdm_transcript_digest(&context->l1l2_context, hash);
+}
+
+int spdm_context_update_l1l2_hash_buffer(void *ctx, void *buf)
 {
 	struct spdm_context *context = (struct spdm_context *)ctx;
 	struct spdm_buffer *buffer = (struct spdm_buffer *)buf;
 	LOG_HEXDUMP_DBG(buffer->data, buffer->write_ptr, "UPDATE L1L2 BUFFER VCA");
 
-	mbedtls_sha512_update(&context->l1l2_context, buffer->data, buffer->write_ptr);
+	return spdm_transcript_update(&context->l1l2_context, buffer->data, buffer->write_ptr);
 }
 
-void spdm_context_update_l1l2_hash(void *ctx, void *req, void *rsp)
+int spdm_context_update_l1l2_hash(void *ctx, void *req, void *rsp)
 {
 	struct spdm_context *context = (struct spdm_context *)ctx;
 	struct spdm_message *req_msg = (struct spdm_message *)req;
@@ -288,18 +385,20 @@ void spdm_context_update_l1l2_hash(void *ctx, void *req, void *rsp)
 			"UPDATE L1L2 rsp_msg->header");
 	LOG_HEXDUMP_DBG((const unsigned char *)rsp_msg->buffer.data, rsp_msg->buffer.write_ptr,
 			"UPDATE L1L2 rsp_msg->buffer");
-	mbedtls_sha512_update(&context->l1l2_context,
+	spdm_transcript_update(&context->l1l2_context,
 			(const unsigned char *)&req_msg->header,
 			sizeof(req_msg->header));
-	mbedtls_sha512_update(&context->l1l2_context,
+	spdm_transcript_update(&context->l1l2_context,
 			(const unsigned char *)req_msg->buffer.data,
 			req_msg->buffer.write_ptr);
-	mbedtls_sha512_update(&context->l1l2_context,
+	spdm_transcript_update(&context->l1l2_context,
 			(const unsigned char *)&rsp_msg->header,
 			sizeof(rsp_msg->header));
-	mbedtls_sha512_update(&context->l1l2_context,
+	spdm_transcript_update(&context->l1l2_context,
 			(const unsigned char *)rsp_msg->buffer.data,
 			rsp_msg->buffer.write_ptr);
+
+	return context->l1l2_context.status;
 }
 
 
@@ -23,6 +23,17 @@ enum SPDM_CONNECTION_STATE {
 	SPDM_STATE_SESSION_ESTABLISHED,
 };
 
+/* SHA-384 transcript digest. With CONFIG_PFR_SPDM_TRANSCRIPT_HW the messages are staged and
+ * hashed by the hash engine when the digest is requested, transcripts outgrowing the staging
+ * buffer continue in software.
+ */
+struct spdm_transcript_hash {
+	struct spdm_buffer staged;
+	mbedtls_sha512_context sw_ctx;
+	bool sw;
+	int status;
+};
+
 struct spdm_version_info {
 	uint8_t version_number_entry_count;
 	uint8_t version_number_selected;
@@ -98,10 +109,10 @@ struct spdm_context {
 	struct spdm_buffer message_c;
 #endif
 	/* M1/M2 Hash Context */
-	struct mbedtls_sha512_context m1m2_context;
+	struct spdm_transcript_hash m1m2_context;
 
 	/* Measurement L1/L2 Hash Context */
-	struct mbedtls_sha512_context l1l2_context;
+	struct spdm_transcript_hash l1l2_context;
 
 	/* Private Key for Signing */
 	mbedtls_ecp_keypair key_pair;
@@ -130,7 +141,9 @@ size_t spdm_context_base_hash_size(void *context);
 size_t spdm_context_base_algo_size(void *context);
 size_t spdm_context_measurement_hash_size(void *context);
 void spdm_context_reset_m1m2_hash(void *ctx);
-void spdm_context_update_m1m2_hash(void *ctx, void *req, void *rsp);
+int spdm_context_get_m1m2_hash(void *ctx, uint8_t *hash);
+int spdm_context_update_m1m2_hash(void *ctx, void *req, void *rsp);
 void spdm_context_reset_l1l2_hash(void *ctx);
-void spdm_context_update_l1l2_hash_buffer(void *ctx, void *buf);
-void spdm_context_update_l1l2_hash(void *ctx, void *req, void *rsp);
+int spdm_context_get_l1l2_hash(void *ctx, uint8_t *hash);
+int spdm_context_update_l1l2_hash_buffer(void *ctx, void *buf);
+int spdm_context_update_l1l2_hash(void *ctx, void *req, void *rsp);
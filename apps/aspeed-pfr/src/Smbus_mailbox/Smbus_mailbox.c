@@ -59,6 +59,22 @@ void ResetMailBox(void)
 	SetUfmCmdTriggerValue(0x00);
 }
 
+static atomic_t provision_data_generation;
+
+/**
+ * Generation of the provisioned data, bumped every time it is erased or rewritten. Caches of
+ * provisioned values snapshot it before reading the UFM and are stale once it changes.
+ **/
+uint32_t get_provision_data_generation(void)
+{
+	return (uint32_t)atomic_get(&provision_data_generation);
+}
+
+void provision_data_changed(void)
+{
+	atomic_inc(&provision_data_generation);
+}
+
 /**
  * Function to Erase th UFM, Key Manifest and State
  * @Param  NULL
@@ -71,9 +87,11 @@ int erase_provision_flash(void)
 	// Erasing provisioned data
 	region_size = pfr_spi_get_device_size(ROT_INTERNAL_INTEL_STATE);
 	if (pfr_spi_erase_region(ROT_INTERNAL_INTEL_STATE, true, 0, region_size)) {
+		provision_data_changed();
 		LOG_ERR("Erase the provisioned UFM data failed");
 		return Failure;
 	}
+	provision_data_changed();
 
 	// Erasing key manifest data
 	region_size = pfr_spi_get_device_size(ROT_INTERNAL_KEY);
@@ -101,9 +119,11 @@ int erase_provision_ufm_flash(void)
 {
 	uint32_t region_size = pfr_spi_get_device_size(ROT_INTERNAL_INTEL_STATE);
 	if (pfr_spi_erase_region(ROT_INTERNAL_INTEL_STATE, true, 0, region_size)) {
+		provision_data_changed();
 		LOG_ERR("Erase the provisioned UFM data failed");
 		return Failure;
 	}
+	provision_data_changed();
 
 	return Success;
 }
@@ -140,6 +160,7 @@ int set_provision_data_in_flash(uint32_t addr, uint8_t *DataBuffer, uint32_t len
 
 	memcpy(buffer + addr, DataBuffer, length);
 	pfr_spi_write(ROT_INTERNAL_INTEL_STATE, 0, ARRAY_SIZE(buffer), buffer);
+	provision_data_changed();
 
 	return status;
 }
@@ -138,6 +138,8 @@ int set_provision_data_in_flash(uint32_t addr, uint8_t *DataBuffer, uint32_t Dat
 int get_provision_data_in_flash(uint32_t addr, uint8_t *DataBuffer, uint32_t length);
 int erase_provision_flash(void);
 int erase_provision_ufm_flash(void);
+uint32_t get_provision_data_generation(void);
+void provision_data_changed(void);
 int ProvisionRootKeyHash(uint8_t *DataBuffer, uint32_t length);
 int ProvisionPchOffsets(uint8_t *DataBuffer, uint32_t length);
 int ProvisionBmcOffsets(uint8_t *DataBuffer, uint32_t length);
@@ -19,10 +19,24 @@
 #include "cerberus_pfr_key_manifest.h"
 #include "cerberus_pfr_recovery.h"
 #include "cerberus_pfr_verification.h"
+#include "Smbus_mailbox/Smbus_mailbox.h"
 #include "crypto/rsa.h"
 
 LOG_MODULE_DECLARE(pfr, CONFIG_LOG_DEFAULT_LEVEL);
 
+#if defined(CONFIG_PFR_ROOT_KEY_HASH_CACHE)
+/*
+ * The root public key which last matched the provisioned root key hash. It is valid only for the
+ * provisioning generation it was checked against.
+ */
+static struct {
+	bool valid;
+	uint32_t generation;
+	struct rsa_public_key public_key;
+} root_key_cache;
+static K_MUTEX_DEFINE(root_key_cache_mutex);
+#endif
+
 /*
  * The root public key is placed in each key manifest.
  * The contentes of root public key from all key manifests should be identical,
@@ -107,10 +121,25 @@ int cerberus_pfr_verify_root_key(struct pfr_manifest *manifest, struct rsa_publi
 	uint8_t hash_buffer[PROVISIONING_ROOT_KEY_HASH_LENGTH];
 	uint32_t hash_length = PROVISIONING_ROOT_KEY_HASH_LENGTH;
 	int status = 0;
+#if defined(CONFIG_PFR_ROOT_KEY_HASH_CACHE)
+	uint32_t generation;
+#endif
 
 	if (!manifest || !public_key)
 		return Failure;
 
+#if defined(CONFIG_PFR_ROOT_KEY_HASH_CACHE)
+	// Snapshot the generation before anything is read from UFM
+	generation = get_provision_data_generation();
+	k_mutex_lock(&root_key_cache_mutex, K_FOREVER);
+	if (root_key_cache.valid && root_key_cache.generation == generation &&
+	    !memcmp(&root_key_cache.public_key, public_key, sizeof(struct rsa_public_key))) {
+		k_mutex_unlock(&root_key_cache_mutex);
+		return Success;
+	}
+	k_mutex_unlock(&root_key_cache_mutex);
+#endif
+
 	if (PROVISIONING_ROOT_KEY_HASH_TYPE == HASH_TYPE_SHA256) {
 		manifest->hash->start_sha256(manifest->hash);
 		manifest->hash->calculate_sha256(manifest->hash, (uint8_t *)public_key, sizeof(struct rsa_public_key), hash_buffer, SHA256_HASH_LENGTH);
@@ -136,6 +165,14 @@ int cerberus_pfr_verify_root_key(struct pfr_manifest *manifest, struct rsa_publi
 		return Failure;
 	}
 
+#if defined(CONFIG_PFR_ROOT_KEY_HASH_CACHE)
+	k_mutex_lock(&root_key_cache_mutex, K_FOREVER);
+	memcpy(&root_key_cache.public_key, public_key, sizeof(struct rsa_public_key));
+	root_key_cache.generation = generation;
+	root_key_cache.valid = true;
+	k_mutex_unlock(&root_key_cache_mutex);
+#endif
+
 	return Success;
 }
 
@@ -293,7 +293,20 @@ int rsa_verify_signature(struct signature_verification *verification,
 	if (cerberus_pfr_verify_root_key(pfr_manifest, &rsa_public))
 		return Failure;
 
+#if defined(CONFIG_PFR_SIG_CACHE)
+	if (pfr_sig_cache_lookup(digest, length, (uint8_t *)&rsa_public, sizeof(rsa_public),
+				signature, sig_length)) {
+		LOG_DBG("RSA signature verified earlier in this boot");
+		return Success;
+	}
+#endif
+
 	status = rsa->base.sig_verify(&rsa->base, &rsa_public, signature, sig_length, digest, length);
+#if defined(CONFIG_PFR_SIG_CACHE)
+	if (status == Success)
+		pfr_sig_cache_insert(digest, length, (uint8_t *)&rsa_public, sizeof(rsa_public),
+				signature, sig_length);
+#endif
 	if (status != Success) {
 		LOG_ERR("public key mod length = 0x%x", rsa_public.mod_length);
 		LOG_ERR("public key exponent = 0x%x", rsa_public.exponent);
@@ -485,6 +498,39 @@ int cerberus_pfr_verify_pfm_csk_key(struct pfr_manifest *pfr_manifest)
 	return Success;
 }
 
+#if defined(CONFIG_PFR_SPI_HASH_STREAM)
+/**
+ * Hash all regions of a signed region list in one streaming pass and verify the signature over
+ * the digest.
+ *
+ * @return 0 if the signature matches, -ENOMEM if no DMA buffer was available or an error code.
+ */
+static int cerberus_verify_region_list(struct pfr_manifest *pfr_manifest,
+		const struct flash_region *region_list, size_t region_count, enum hash_type hash_type,
+		const uint8_t *signature, size_t sig_length, const struct rsa_public_key *pub_key,
+		uint8_t *hash_buf, size_t hash_length)
+{
+	struct rsa_engine *rsa = &getRsaEngineInstance()->base;
+	struct pfr_spi_extent extents[region_count];
+	int status;
+
+	if (hash_type != HASH_TYPE_SHA256)
+		return -ENOMEM;
+
+	for (size_t i = 0; i < region_count; i++) {
+		extents[i].device_id = pfr_manifest->image_type;
+		extents[i].address = region_list[i].start_addr;
+		extents[i].length = region_list[i].length;
+	}
+
+	status = pfr_spi_hash_extents(extents, region_count, HASH_SHA256, hash_buf, hash_length);
+	if (status)
+		return status;
+
+	return rsa->sig_verify(rsa, pub_key, signature, sig_length, hash_buf, SHA256_HASH_LENGTH);
+}
+#endif
+
 int cerberus_verify_regions(struct pfr_manifest *pfr_manifest)
 {
 	if (!pfr_manifest)
@@ -590,6 +636,21 @@ int cerberus_verify_regions(struct pfr_manifest *pfr_manifest)
 			continue;
 		}
 
+#if defined(CONFIG_PFR_SPI_HASH_STREAM)
+		int status = cerberus_verify_region_list(pfr_manifest, region_list,
+				fw_ver_element_img.region_count, manifest_flash->toc_hash_type,
+				signature, manifest_flash->header.sig_length, &pub_key,
+				hashStorage, manifest_flash->header.sig_length);
+
+		if (status == Success) {
+			LOG_INF("Signed Region(%d): Digest verification succeeded", signed_region_id);
+			continue;
+		} else if (status != -ENOMEM) {
+			LOG_ERR("Signed Region(%d): Digest verification failed", signed_region_id);
+			return Failure;
+		}
+#endif
+
 		if (flash_verify_noncontiguous_contents((struct flash *)pfr_manifest->flash,
 				region_list,
 				fw_ver_element_img.region_count,
@@ -72,11 +72,10 @@ int initializeEngines(void)
 #if defined(CONFIG_SEAMLESS_UPDATE)
 void apply_fvm_spi_protection(uint32_t fvm_addr)
 {
-	uint32_t fvm_offset = fvm_addr + PFM_SIG_BLOCK_SIZE;
-	uint32_t fvm_body_offset = fvm_offset + sizeof(FVM_STRUCTURE);
-	FVM_STRUCTURE fvm;
-	PFM_SPI_DEFINITION spi_def;
-	uint32_t fvm_body_end_addr;
+	const struct pfm_index *index;
+	const struct pfm_index_entry *entry;
+	struct pfm_index_iter iter;
+	const PFM_SPI_DEFINITION *spi_def;
 	uint32_t region_start_address;
 	uint32_t region_end_address;
 	int region_length;
@@ -89,74 +88,67 @@ void apply_fvm_spi_protection(uint32_t fvm_addr)
 		"spi_m4"
 	};
 
-	pfr_spi_read(PCH_SPI, fvm_offset, sizeof(FVM_STRUCTURE), (uint8_t *)&fvm);
-	fvm_body_end_addr = fvm_offset + fvm.Length;
+	if (pfm_index_get(PCH_SPI, fvm_addr, PFM_INDEX_FVM, &index)) {
+		LOG_ERR("Failed to get FVM at %x, FVM SPI filter rules not applied", fvm_addr);
+		return;
+	}
+
+	pfm_index_iter_init(&iter, index);
+	while ((entry = pfm_index_next(&iter)) != NULL) {
+		if (entry->type != SPI_REGION)
+			continue;
 
-	while (fvm_body_offset < fvm_body_end_addr) {
-		pfr_spi_read(PCH_SPI, fvm_body_offset, sizeof(PFM_SPI_DEFINITION),
-				(uint8_t *)&spi_def);
-		if (spi_def.PFMDefinitionType == SPI_REGION) {
-			region_start_address = spi_def.RegionStartAddress;
-			region_end_address = spi_def.RegionEndAddress;
-			region_length = region_end_address - region_start_address;
+		spi_def = &entry->spi.def;
+		region_start_address = spi_def->RegionStartAddress;
+		region_end_address = spi_def->RegionEndAddress;
+		region_length = region_end_address - region_start_address;
 #if defined(CONFIG_CPU_DUAL_FLASH)
-			flash_size = pfr_spi_get_device_size(PCH_SPI);
-			if (region_start_address >= flash_size && (region_end_address - 1) >= flash_size) {
-				region_start_address -= flash_size;
-				region_end_address -= flash_size;
-				spi_id = 1;
-			} else if (region_start_address < flash_size && (region_end_address - 1) >= flash_size) {
-				LOG_ERR("ERROR: region start and end address should be in the same flash");
-				return;
-			} else {
-				spi_id = 0;
-			}
+		flash_size = pfr_spi_get_device_size(PCH_SPI);
+		if (region_start_address >= flash_size && (region_end_address - 1) >= flash_size) {
+			region_start_address -= flash_size;
+			region_end_address -= flash_size;
+			spi_id = 1;
+		} else if (region_start_address < flash_size && (region_end_address - 1) >= flash_size) {
+			LOG_ERR("ERROR: region start and end address should be in the same flash");
+			break;
+		} else {
+			spi_id = 0;
+		}
 #endif
-			if (spi_def.ProtectLevelMask.ReadAllowed) {
-				Set_SPI_Filter_RW_Region(pch_spim_devs[spi_id], SPI_FILTER_READ_PRIV,
-						SPI_FILTER_PRIV_ENABLE, region_start_address,
-						region_length);
-				LOG_INF("SPI_ID[2] fvm read enable 0x%08x to 0x%08x",
-					region_start_address,
-					region_end_address);
-			} else {
-				Set_SPI_Filter_RW_Region(pch_spim_devs[spi_id], SPI_FILTER_READ_PRIV,
-						SPI_FILTER_PRIV_DISABLE, region_start_address,
-						region_length);
-				LOG_INF("SPI_ID[2] fvm read disable 0x%08x to 0x%08x",
-					region_start_address,
-					region_end_address);
-			}
-
-			if (spi_def.ProtectLevelMask.WriteAllowed) {
-				Set_SPI_Filter_RW_Region(pch_spim_devs[spi_id], SPI_FILTER_WRITE_PRIV,
-						SPI_FILTER_PRIV_ENABLE, region_start_address,
-						region_length);
-				LOG_INF("SPI_ID[2] fvm write enable 0x%08x to 0x%08x",
-					region_start_address,
-					region_end_address);
-			} else {
-				Set_SPI_Filter_RW_Region(pch_spim_devs[spi_id], SPI_FILTER_WRITE_PRIV,
-						SPI_FILTER_PRIV_DISABLE, region_start_address,
-						region_length);
-				LOG_INF("SPI_ID[2] fvm write disable 0x%08x to 0x%08x",
-					region_start_address,
-					region_end_address);
-			}
-
-			if (spi_def.HashAlgorithmInfo.SHA256HashPresent) {
-				fvm_body_offset += sizeof(PFM_SPI_DEFINITION) + SHA256_SIZE;
-			} else if (spi_def.HashAlgorithmInfo.SHA384HashPresent) {
-				fvm_body_offset += sizeof(PFM_SPI_DEFINITION) + SHA384_SIZE;
-			} else {
-				fvm_body_offset += SPI_REGION_DEF_MIN_SIZE;
-			}
-		} else if (spi_def.PFMDefinitionType == FVM_CAP) {
-			fvm_body_offset += sizeof(FVM_CAPABLITIES);
+		if (spi_def->ProtectLevelMask.ReadAllowed) {
+			Set_SPI_Filter_RW_Region(pch_spim_devs[spi_id], SPI_FILTER_READ_PRIV,
+					SPI_FILTER_PRIV_ENABLE, region_start_address,
+					region_length);
+			LOG_INF("SPI_ID[2] fvm read enable 0x%08x to 0x%08x",
+				region_start_address,
+				region_end_address);
 		} else {
-			break;
+			Set_SPI_Filter_RW_Region(pch_spim_devs[spi_id], SPI_FILTER_READ_PRIV,
+					SPI_FILTER_PRIV_DISABLE, region_start_address,
+					region_length);
+			LOG_INF("SPI_ID[2] fvm read disable 0x%08x to 0x%08x",
+				region_start_address,
+				region_end_address);
+		}
+
+		if (spi_def->ProtectLevelMask.WriteAllowed) {
+			Set_SPI_Filter_RW_Region(pch_spim_devs[spi_id], SPI_FILTER_WRITE_PRIV,
+					SPI_FILTER_PRIV_ENABLE, region_start_address,
+					region_length);
+			LOG_INF("SPI_ID[2] fvm write enable 0x%08x to 0x%08x",
+				region_start_address,
+				region_end_address);
+		} else {
+			Set_SPI_Filter_RW_Region(pch_spim_devs[spi_id], SPI_FILTER_WRITE_PRIV,
+					SPI_FILTER_PRIV_DISABLE, region_start_address,
+					region_length);
+			LOG_INF("SPI_ID[2] fvm write disable 0x%08x to 0x%08x",
+				region_start_address,
+				region_end_address);
 		}
 	}
+
+	pfm_index_put(index);
 }
 #endif
 
@@ -103,6 +103,7 @@
 
 #define SHA384_SIZE                     48
 #define SHA256_SIZE                     32
+#define SHA512_SIZE                     64
 
 #define SHA256_DIGEST_LENGTH            32
 #define SHA384_DIGEST_LENGTH            48
@@ -4,6 +4,8 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <zephyr.h>
+#include <string.h>
 #include <logging/log.h>
 #include <flash/flash_aspeed.h>
 
@@ -151,8 +153,331 @@ int get_recover_pfm_version_details(struct pfr_manifest *manifest, uint32_t addr
 	return status;
 }
 
+/*
+ * PFM and FVM bodies are read through a window and parsed once into a pfm_index, which is
+ * shared by region verification and SPI/SMBus filter setup. Parsed tables are kept while the
+ * write generation of their flash device is unchanged.
+ */
+struct pfm_index_slot {
+	struct pfm_index index;
+	bool valid;
+	uint8_t refs;
+	uint32_t generation;
+	uint32_t last_used;
+};
+
+static struct pfm_index_slot pfm_index_cache[CONFIG_PFR_PFM_INDEX_CACHE_SIZE];
+static uint8_t pfm_index_window[CONFIG_PFR_PFM_INDEX_READ_SIZE];
+static uint32_t pfm_index_clock;
+static K_MUTEX_DEFINE(pfm_index_mutex);
+
+BUILD_ASSERT(PFM_INDEX_STREAM_WINDOW_SIZE >= sizeof(PFM_SPI_DEFINITION) + SHA512_SIZE &&
+		PFM_INDEX_STREAM_WINDOW_SIZE >= sizeof(PFM_SMBUS_RULE) &&
+		PFM_INDEX_STREAM_WINDOW_SIZE >= sizeof(PFM_FVM_ADDRESS_DEFINITION),
+		"PFM stream window does not hold the largest definition");
+
+/* Return length bytes at address, reading the next window from flash when needed. */
+static const uint8_t *pfm_index_fetch(struct pfm_index_reader *reader, uint32_t address,
+		uint32_t length)
+{
+	uint32_t read_length;
+
+	if (address >= reader->base && address + length <= reader->base + reader->length)
+		return &reader->window[address - reader->base];
+
+	if (address >= reader->limit || length > reader->limit - address)
+		return NULL;
+
+	read_length = MIN(reader->limit - address, reader->window_size);
+	if (read_length < length)
+		return NULL;
+
+	if (pfr_spi_read(reader->device_id, address, read_length, reader->window)) {
+		reader->length = 0;
+		return NULL;
+	}
+
+	reader->base = address;
+	reader->length = read_length;
+
+	return reader->window;
+}
+
+/*
+ * Decode the definition at *offset into entry and move *offset past it.
+ *
+ * Returns 1 if entry holds a definition, 0 at the end of the body or a negative error code.
+ */
+static int pfm_index_decode(struct pfm_index_reader *reader, uint8_t kind, uint32_t *offset,
+		struct pfm_index_entry *entry)
+{
+	const PFM_SPI_DEFINITION *spi_def;
+	const uint8_t *record;
+	uint32_t hash_length;
+
+	while (*offset < reader->limit) {
+		record = pfm_index_fetch(reader, *offset, 1);
+		if (record == NULL)
+			return -EIO;
+
+		switch (record[0]) {
+		case SPI_REGION:
+			spi_def = (const PFM_SPI_DEFINITION *)pfm_index_fetch(reader, *offset,
+					sizeof(PFM_SPI_DEFINITION));
+			if (spi_def == NULL)
+				return -EIO;
+
+			if (spi_def->HashAlgorithmInfo.SHA256HashPresent)
+				hash_length = SHA256_SIZE;
+			else if (spi_def->HashAlgorithmInfo.SHA384HashPresent)
+				hash_length = SHA384_SIZE;
+			else if (spi_def->HashAlgorithmInfo.SHA512HashPresent)
+				hash_length = SHA512_SIZE;
+			else
+				hash_length = 0;
+
+			record = pfm_index_fetch(reader, *offset,
+					sizeof(PFM_SPI_DEFINITION) + hash_length);
+			if (record == NULL)
+				return -EIO;
+
+			entry->type = SPI_REGION;
+			memcpy(&entry->spi.def, record, sizeof(PFM_SPI_DEFINITION));
+			memset(entry->spi.hash, 0, sizeof(entry->spi.hash));
+			memcpy(entry->spi.hash, record + sizeof(PFM_SPI_DEFINITION),
+					MIN(hash_length, sizeof(entry->spi.hash)));
+			*offset += sizeof(PFM_SPI_DEFINITION) + hash_length;
+			return 1;
+		case SMBUS_RULE:
+			if (kind != PFM_INDEX_PFM)
+				return 0;
+
+			record = pfm_index_fetch(reader, *offset, sizeof(PFM_SMBUS_RULE));
+			if (record == NULL)
+				return -EIO;
+
+			entry->type = SMBUS_RULE;
+			memcpy(&entry->smbus, record, sizeof(PFM_SMBUS_RULE));
+			*offset += sizeof(PFM_SMBUS_RULE);
+			return 1;
+		case FVM_ADDR_DEF:
+			if (kind != PFM_INDEX_PFM)
+				return 0;
+
+			record = pfm_index_fetch(reader, *offset,
+					sizeof(PFM_FVM_ADDRESS_DEFINITION));
+			if (record == NULL)
+				return -EIO;
+
+			entry->type = FVM_ADDR_DEF;
+			memcpy(&entry->fvm, record, sizeof(PFM_FVM_ADDRESS_DEFINITION));
+			*offset += sizeof(PFM_FVM_ADDRESS_DEFINITION);
+			return 1;
+		case FVM_CAP:
+			*offset += sizeof(FVM_CAPABLITIES);
+			break;
+		default:
+			return 0;
+		}
+	}
+
+	return 0;
+}
+
+static int pfm_index_parse(struct pfm_index *index, uint8_t device_id, uint32_t address,
+		uint8_t kind)
+{
+	struct pfm_index_reader reader = {
+		device_id, pfm_index_window, sizeof(pfm_index_window), 0, 0, 0
+	};
+	uint32_t offset = address + PFM_SIG_BLOCK_SIZE;
+	struct pfm_index_entry entry;
+	const uint8_t *record;
+	uint32_t header_length;
+	int ret;
+
+	memset(index, 0, offsetof(struct pfm_index, entries));
+	index->device_id = device_id;
+	index->address = address;
+	index->kind = kind;
+
+	header_length = (kind == PFM_INDEX_FVM) ? sizeof(FVM_STRUCTURE) : sizeof(PFM_STRUCTURE);
+	reader.limit = offset + header_length;
+	record = pfm_index_fetch(&reader, offset, header_length);
+	if (record == NULL)
+		return Failure;
+
+	if (kind == PFM_INDEX_FVM) {
+		if (((const FVM_STRUCTURE *)record)->FvmTag != FVMTAG) {
+			LOG_ERR("FVMTag verification failed...\n expected: %x\n actual: %x",
+					FVMTAG, ((const FVM_STRUCTURE *)record)->FvmTag);
+			return Failure;
+		}
+		index->body_end = offset + ((const FVM_STRUCTURE *)record)->Length;
+	} else {
+		index->body_end = offset + ((const PFM_STRUCTURE *)record)->Length;
+	}
+
+	offset += header_length;
+	index->body_start = offset;
+	reader.limit = index->body_end;
+	reader.length = 0;
+
+	while ((ret = pfm_index_decode(&reader, kind, &offset, &entry)) > 0) {
+		if (index->entry_count >= ARRAY_SIZE(index->entries)) {
+			// Too large to keep, pfm_index_next() reads it from flash instead
+			LOG_WRN("Manifest at dev(%d) address(%x) has more than %d definitions",
+					device_id, address, CONFIG_PFR_PFM_INDEX_MAX_ENTRIES);
+			index->overflow = true;
+			return Success;
+		}
+
+		index->entries[index->entry_count++] = entry;
+		if (entry.type == SPI_REGION)
+			index->spi_region_count++;
+		else if (entry.type == SMBUS_RULE)
+			index->smbus_rule_count++;
+		else
+			index->fvm_count++;
+	}
+
+	return ret ? Failure : Success;
+}
+
+/**
+ * Get the parsed definitions of a PFM or FVM.
+ *
+ * The body is read from flash and parsed on the first request, later requests for the same
+ * manifest are served from memory until its flash device is written. The table must be released
+ * with pfm_index_put().
+ *
+ * @param device_id flash device holding the manifest
+ * @param address address of the manifest signature block
+ * @param kind PFM_INDEX_PFM or PFM_INDEX_FVM
+ * @param index output table
+ *
+ * @return 0 if the manifest was parsed or an error code.
+ */
+int pfm_index_get(uint8_t device_id, uint32_t address, uint8_t kind,
+		const struct pfm_index **index)
+{
+	struct pfm_index_slot *slot = NULL;
+	uint32_t generation = 0;
+	size_t i;
+
+#if defined(CONFIG_FLASH_WRITE_GENERATION)
+	generation = flash_write_generation_get(device_id);
+#endif
+
+	k_mutex_lock(&pfm_index_mutex, K_FOREVER);
+	for (i = 0; i < ARRAY_SIZE(pfm_index_cache); i++) {
+		struct pfm_index_slot *candidate = &pfm_index_cache[i];
+
+#if defined(CONFIG_FLASH_WRITE_GENERATION)
+		if (candidate->valid && candidate->generation == generation &&
+		    candidate->index.device_id == device_id &&
+		    candidate->index.address == address && candidate->index.kind == kind) {
+			slot = candidate;
+			break;
+		}
+#endif
+		// Pick a free slot, otherwise the least recently used one which is not in use
+		if (candidate->refs)
+			continue;
+		if (slot == NULL || !candidate->valid ||
+		    (slot->valid && candidate->last_used < slot->last_used))
+			slot = candidate;
+	}
+
+	if (slot == NULL) {
+		k_mutex_unlock(&pfm_index_mutex);
+		LOG_ERR("No free PFM index slot");
+		return Failure;
+	}
+
+	if (!slot->valid || slot->generation != generation ||
+	    slot->index.device_id != device_id || slot->index.address != address ||
+	    slot->index.kind != kind ||
+	    !IS_ENABLED(CONFIG_FLASH_WRITE_GENERATION)) {
+		slot->valid = false;
+		if (pfm_index_parse(&slot->index, device_id, address, kind)) {
+			k_mutex_unlock(&pfm_index_mutex);
+			LOG_ERR("Failed to parse manifest at dev(%d) address(%x)", device_id,
+					address);
+			return Failure;
+		}
+		slot->generation = generation;
+		slot->valid = true;
+	}
+
+	slot->refs++;
+	slot->last_used = ++pfm_index_clock;
+	k_mutex_unlock(&pfm_index_mutex);
+	*index = &slot->index;
+
+	return Success;
+}
+
+void pfm_index_put(const struct pfm_index *index)
+{
+	struct pfm_index_slot *slot = CONTAINER_OF(index, struct pfm_index_slot, index);
+
+	k_mutex_lock(&pfm_index_mutex, K_FOREVER);
+	if (slot->refs)
+		slot->refs--;
+	k_mutex_unlock(&pfm_index_mutex);
+}
+
+/**
+ * Start walking the definitions of a manifest in body order.
+ *
+ * @param iter cursor, it holds the read window of an overflowed manifest
+ * @param index table returned by pfm_index_get()
+ */
+void pfm_index_iter_init(struct pfm_index_iter *iter, const struct pfm_index *index)
+{
+	iter->index = index;
+	iter->pos = 0;
+	iter->offset = index->body_start;
+	iter->status = Success;
+	iter->reader.device_id = index->device_id;
+	iter->reader.window = iter->window;
+	iter->reader.window_size = sizeof(iter->window);
+	iter->reader.base = 0;
+	iter->reader.length = 0;
+	iter->reader.limit = index->body_end;
+}
+
+/**
+ * Get the next definition of a manifest.
+ *
+ * @return the definition, valid until the next call, or NULL at the end of the body. iter->status
+ * tells whether the whole body was walked.
+ */
+const struct pfm_index_entry *pfm_index_next(struct pfm_index_iter *iter)
+{
+	const struct pfm_index *index = iter->index;
+	int ret;
+
+	if (!index->overflow) {
+		if (iter->pos >= index->entry_count)
+			return NULL;
+
+		return &index->entries[iter->pos++];
+	}
+
+	ret = pfm_index_decode(&iter->reader, index->kind, &iter->offset, &iter->entry);
+	if (ret < 0) {
+		LOG_ERR("Failed to read manifest at dev(%d) address(%x)", index->device_id,
+				iter->offset);
+		iter->status = Failure;
+	}
+
+	return (ret > 0) ? &iter->entry : NULL;
+}
+
 int spi_region_hash_verification(struct pfr_manifest *pfr_manifest,
-		PFM_SPI_DEFINITION *PfmSpiDefinition, uint8_t *pfm_spi_Hash)
+		const PFM_SPI_DEFINITION *PfmSpiDefinition, const uint8_t *pfm_spi_Hash)
 {
 
 	uint32_t region_length;
@@ -182,13 +507,25 @@ int spi_region_hash_verification(struct pfr_manifest *pfr_manifest,
 		}
 
 		pfr_manifest->flash->state->device_id[0] = pfr_manifest->image_type;
+#if defined(CONFIG_PFR_REGION_CHUNK_DIGEST)
+		if (get_hash_chunked((struct manifest *)pfr_manifest, pfr_manifest->hash,
+				pfm_spi_Hash, sha_buffer, hash_length, NULL) == -EBADMSG) {
+			LOG_ERR("Digest verification failed");
+			return Failure;
+		}
+#else
 		pfr_manifest->base->get_hash((struct manifest *)pfr_manifest, pfr_manifest->hash,
 				sha_buffer, hash_length);
+#endif
 
 		if (memcmp(pfm_spi_Hash, sha_buffer, hash_length)) {
 			LOG_ERR("Digest verification failed");
 			return Failure;
 		}
+#if defined(CONFIG_PFR_REGION_CHUNK_DIGEST)
+		pfr_region_chunk_trust(pfr_manifest->image_type, pfr_manifest->pfr_hash->type,
+				PfmSpiDefinition->RegionStartAddress, region_length, sha_buffer);
+#endif
 		LOG_INF("Digest verification succeeded");
 	}
 
@@ -196,34 +533,13 @@ int spi_region_hash_verification(struct pfr_manifest *pfr_manifest,
 	return Success;
 }
 
-int get_spi_region_hash(struct pfr_manifest *manifest, uint32_t address,
-		PFM_SPI_DEFINITION *p_spi_definition, uint8_t *pfm_spi_hash)
-{
-	if (p_spi_definition->HashAlgorithmInfo.SHA256HashPresent == 1) {
-		pfr_spi_read(manifest->image_type, address, SHA256_SIZE,
-				pfm_spi_hash);
-
-		return SHA256_SIZE;
-	} else if (p_spi_definition->HashAlgorithmInfo.SHA384HashPresent == 1) {
-		pfr_spi_read(manifest->image_type, address, SHA384_SIZE,
-				pfm_spi_hash);
-
-		return SHA384_SIZE;
-	}
-
-	return 0;
-}
-
 #if defined(CONFIG_SEAMLESS_UPDATE)
 int fvm_spi_region_verification(struct pfr_manifest *manifest)
 {
-	uint32_t read_address = manifest->address;
-	FVM_STRUCTURE fvm_data;
-	bool done = false;
-	uint32_t fvm_addr = read_address + PFM_SIG_BLOCK_SIZE;
-	uint32_t fvm_end_addr;
-	PFM_SPI_DEFINITION spi_definition = { 0 };
-	uint8_t pfm_spi_hash[SHA384_SIZE] = { 0 };
+	const struct pfm_index *index;
+	const struct pfm_index_entry *entry;
+	struct pfm_index_iter iter;
+	int status = Success;
 
 	LOG_INF("Verifying FVM...");
 	if (manifest->base->verify((struct manifest *)manifest, manifest->hash,
@@ -233,113 +549,66 @@ int fvm_spi_region_verification(struct pfr_manifest *manifest)
 		return Failure;
 	}
 
-	if (pfr_spi_read(manifest->image_type, fvm_addr,
-			sizeof(FVM_STRUCTURE), (uint8_t *)&fvm_data))
-		return Failure;
-
-	if (fvm_data.FvmTag != FVMTAG) {
-		LOG_ERR("FVMTag verification failed...\n expected: %x\n actual: %x",
-				FVMTAG, fvm_data.FvmTag);
+	if (pfm_index_get(manifest->image_type, manifest->address, PFM_INDEX_FVM, &index))
 		return Failure;
-	}
 
-	fvm_end_addr = fvm_addr + fvm_data.Length;
-	fvm_addr += sizeof(FVM_STRUCTURE);
-
-	while (!done) {
-		if (pfr_spi_read(manifest->image_type, fvm_addr,
-				sizeof(PFM_SPI_DEFINITION), (uint8_t *)&spi_definition))
-			return Failure;
+	pfm_index_iter_init(&iter, index);
+	while ((entry = pfm_index_next(&iter)) != NULL) {
+		if (entry->type != SPI_REGION)
+			continue;
 
-		switch (spi_definition.PFMDefinitionType) {
-		case SPI_REGION:
-			fvm_addr += sizeof(PFM_SPI_DEFINITION);
-			fvm_addr += get_spi_region_hash(manifest, fvm_addr, &spi_definition,
-					pfm_spi_hash);
-			if (spi_region_hash_verification(manifest, &spi_definition,
-							pfm_spi_hash))
-				return Failure;
-
-			memset(&spi_definition, 0, sizeof(PFM_SPI_DEFINITION));
-			memset(pfm_spi_hash, 0, SHA384_SIZE);
-			break;
-		case PCH_FVM_CAP:
-			fvm_addr += sizeof(FVM_CAPABLITIES);
-			break;
-		default:
-			done = true;
+		if (spi_region_hash_verification(manifest, &entry->spi.def, entry->spi.hash)) {
+			status = Failure;
 			break;
 		}
-
-		if (fvm_addr >= fvm_end_addr)
-			break;
 	}
 
-	return Success;
+	if (iter.status)
+		status = Failure;
+	pfm_index_put(index);
+
+	return status;
 }
 #endif
 
 int pfm_spi_region_verification(struct pfr_manifest *manifest)
 {
 	uint32_t read_address = manifest->address;
-	PFM_STRUCTURE pfm_data;
-	bool done = false;
-	uint32_t pfm_addr = read_address + PFM_SIG_BLOCK_SIZE;
-	uint32_t pfm_end_addr;
-#if defined(CONFIG_SEAMLESS_UPDATE)
-	PFM_FVM_ADDRESS_DEFINITION *fvm_def;
-#endif
-	PFM_SPI_DEFINITION spi_definition = { 0 };
-	uint8_t pfm_spi_hash[SHA384_SIZE] = { 0 };
+	const struct pfm_index *index;
+	const struct pfm_index_entry *entry;
+	struct pfm_index_iter iter;
+	int status = Success;
 
-	if (pfr_spi_read(manifest->image_type, pfm_addr,
-			sizeof(PFM_STRUCTURE), (uint8_t *)&pfm_data))
+	if (pfm_index_get(manifest->image_type, read_address, PFM_INDEX_PFM, &index))
 		return Failure;
-	pfm_end_addr = pfm_addr + pfm_data.Length;
-	pfm_addr += sizeof(PFM_STRUCTURE);
-
-	while (!done) {
-		if (pfr_spi_read(manifest->image_type, pfm_addr,
-				sizeof(PFM_SPI_DEFINITION), (uint8_t *)&spi_definition))
-			return Failure;
 
-		switch (spi_definition.PFMDefinitionType) {
+	pfm_index_iter_init(&iter, index);
+	while (status == Success && (entry = pfm_index_next(&iter)) != NULL) {
+		switch (entry->type) {
 		case SPI_REGION:
-			pfm_addr += sizeof(PFM_SPI_DEFINITION);
-			pfm_addr += get_spi_region_hash(manifest, pfm_addr, &spi_definition,
-					pfm_spi_hash);
-			if (spi_region_hash_verification(manifest, &spi_definition,
-					pfm_spi_hash))
-				return Failure;
-
-			memset(&spi_definition, 0, sizeof(PFM_SPI_DEFINITION));
-			memset(pfm_spi_hash, 0, SHA384_SIZE);
-			break;
-		case SMBUS_RULE:
-			pfm_addr += sizeof(PFM_SMBUS_RULE);
+			if (spi_region_hash_verification(manifest, &entry->spi.def,
+					entry->spi.hash))
+				status = Failure;
 			break;
 #if defined(CONFIG_SEAMLESS_UPDATE)
 		case FVM_ADDR_DEF:
-			fvm_def = (PFM_FVM_ADDRESS_DEFINITION *)&spi_definition;
-			manifest->address = fvm_def->FVMAddress;
+			manifest->address = entry->fvm.FVMAddress;
 			if (fvm_spi_region_verification(manifest)) {
-				manifest->address = read_address;
 				LOG_ERR("FVM SPI region verification failed");
-				return Failure;
+				status = Failure;
 			}
-			pfm_addr += sizeof(PFM_FVM_ADDRESS_DEFINITION);
 			break;
 #endif
 		default:
-			done = true;
 			break;
 		}
-
-		if (pfm_addr >= pfm_end_addr)
-			break;
 	}
+
+	if (iter.status)
+		status = Failure;
+	pfm_index_put(index);
 	manifest->address = read_address;
 
-	return Success;
+	return status;
 }
 
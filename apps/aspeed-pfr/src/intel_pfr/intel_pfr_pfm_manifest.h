@@ -6,8 +6,10 @@
 
 #pragma once
 
+#include <stdbool.h>
 #include <stdint.h>
 #include "pfr/pfr_common.h"
+#include "intel_pfr_definitions.h"
 
 #define BIOS1_BIOS2 0x00
 #define ME_SPS          0x01
@@ -41,7 +43,8 @@ typedef struct PFMSPIDEFINITION {
 	struct {
 		uint16_t SHA256HashPresent : 1;
 		uint16_t SHA384HashPresent : 1;
-		uint16_t Reserved : 14;
+		uint16_t SHA512HashPresent : 1;
+		uint16_t Reserved : 13;
 	} HashAlgorithmInfo;
 	uint32_t Reserved;
 	uint32_t RegionStartAddress;
@@ -210,7 +213,81 @@ typedef struct _CFM_STRUCTURE {
 
 #pragma pack()
 
+#if defined(CONFIG_INTEL_PFR)
+enum {
+	PFM_INDEX_PFM = 0,
+	PFM_INDEX_FVM,
+};
+
+/**
+ * One SPI region, SMBus rule or FVM address definition of a PFM or FVM, in body order.
+ */
+struct pfm_index_entry {
+	uint8_t type;				/**< SPI_REGION, SMBUS_RULE or FVM_ADDR_DEF. */
+	union {
+		struct {
+			PFM_SPI_DEFINITION def;
+			uint8_t hash[SHA384_SIZE];	/**< Expected digest if a hash is present. */
+		} spi;
+		PFM_SMBUS_RULE smbus;
+		PFM_FVM_ADDRESS_DEFINITION fvm;
+	};
+};
+
+/**
+ * In-memory table of the definitions of a PFM or FVM body, parsed in a single pass.
+ *
+ * A body with more than CONFIG_PFR_PFM_INDEX_MAX_ENTRIES definitions is marked as overflowed
+ * and is read from flash again while it is iterated, use pfm_index_next() to walk either.
+ */
+struct pfm_index {
+	uint8_t device_id;			/**< Flash device holding the manifest. */
+	uint8_t kind;				/**< PFM_INDEX_PFM or PFM_INDEX_FVM. */
+	bool overflow;				/**< entries[] does not hold the whole body. */
+	uint32_t address;			/**< Manifest address, at its signature block. */
+	uint32_t body_start;			/**< First definition. */
+	uint32_t body_end;			/**< End of the body. */
+	uint16_t spi_region_count;
+	uint16_t smbus_rule_count;
+	uint16_t fvm_count;
+	uint16_t entry_count;
+	struct pfm_index_entry entries[CONFIG_PFR_PFM_INDEX_MAX_ENTRIES];
+};
+
+/* Large enough for the largest definition, a SPI region with a SHA-512 hash */
+#define PFM_INDEX_STREAM_WINDOW_SIZE	128
+
+struct pfm_index_reader {
+	uint8_t device_id;
+	uint8_t *window;
+	uint32_t window_size;
+	uint32_t base;
+	uint32_t length;
+	uint32_t limit;
+};
+
+/**
+ * Cursor over the definitions of a pfm_index, see pfm_index_iter_init().
+ */
+struct pfm_index_iter {
+	const struct pfm_index *index;
+	uint16_t pos;
+	uint32_t offset;
+	int status;				/**< Failure if the body could not be read. */
+	struct pfm_index_reader reader;
+	struct pfm_index_entry entry;
+	uint8_t window[PFM_INDEX_STREAM_WINDOW_SIZE];
+};
+#endif
+
 int get_recover_pfm_version_details(struct pfr_manifest *manifest, uint32_t address);
 int get_active_pfm_version_details(struct pfr_manifest *manifest, uint32_t address);
 int pfm_spi_region_verification(struct pfr_manifest *manifest);
 
+#if defined(CONFIG_INTEL_PFR)
+int pfm_index_get(uint8_t device_id, uint32_t address, uint8_t kind,
+		const struct pfm_index **index);
+void pfm_index_put(const struct pfm_index *index);
+void pfm_index_iter_init(struct pfm_index_iter *iter, const struct pfm_index *index);
+const struct pfm_index_entry *pfm_index_next(struct pfm_index_iter *iter);
+#endif
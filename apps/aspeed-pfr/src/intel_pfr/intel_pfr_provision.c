@@ -5,6 +5,7 @@
  */
 
 #include <logging/log.h>
+#include <zephyr.h>
 #include <stdint.h>
 #include "AspeedStateMachine/common_smc.h"
 #include "pfr/pfr_common.h"
@@ -13,9 +14,27 @@
 #include "pfr/pfr_util.h"
 #include "intel_pfr_provision.h"
 #include "intel_pfr_verification.h"
+#include "Smbus_mailbox/Smbus_mailbox.h"
 
 LOG_MODULE_DECLARE(pfr, CONFIG_LOG_DEFAULT_LEVEL);
 
+#if defined(CONFIG_PFR_ROOT_KEY_HASH_CACHE)
+/**
+ * The provisioned root key hash is read from UFM once and the last root key entry which matched
+ * it is remembered. Both are dropped when the provisioned data generation changes.
+ */
+static struct {
+	bool ufm_valid;
+	bool key_valid;
+	uint32_t generation;
+	uint8_t ufm_sha_data[SHA384_DIGEST_LENGTH];
+	uint8_t hash_curve;
+	uint8_t pubkey_x[SHA384_DIGEST_LENGTH];
+	uint8_t pubkey_y[SHA384_DIGEST_LENGTH];
+} root_key_hash_cache;
+static K_MUTEX_DEFINE(root_key_hash_cache_mutex);
+#endif
+
 int verify_root_key_hash(struct pfr_manifest *manifest, uint8_t *pubkey_x, uint8_t *pubkey_y)
 {
 	uint8_t root_public_key[SHA384_DIGEST_LENGTH * 2] = { 0 };
@@ -24,6 +43,10 @@ int verify_root_key_hash(struct pfr_manifest *manifest, uint8_t *pubkey_x, uint8
 	uint8_t digest_length = 0;
 	uint8_t i = 0;
 	int status;
+#if defined(CONFIG_PFR_ROOT_KEY_HASH_CACHE)
+	uint32_t generation;
+	bool cached = false;
+#endif
 
 	if (manifest->hash_curve == secp256r1)
 		digest_length = SHA256_DIGEST_LENGTH;
@@ -34,6 +57,28 @@ int verify_root_key_hash(struct pfr_manifest *manifest, uint8_t *pubkey_x, uint8
 		return Failure;
 	}
 
+#if defined(CONFIG_PFR_ROOT_KEY_HASH_CACHE)
+	// Snapshot the generation before anything is read from UFM
+	generation = get_provision_data_generation();
+	k_mutex_lock(&root_key_hash_cache_mutex, K_FOREVER);
+	if (root_key_hash_cache.generation != generation) {
+		root_key_hash_cache.ufm_valid = false;
+		root_key_hash_cache.key_valid = false;
+	}
+	if (root_key_hash_cache.key_valid &&
+	    root_key_hash_cache.hash_curve == manifest->hash_curve &&
+	    !memcmp(root_key_hash_cache.pubkey_x, pubkey_x, digest_length) &&
+	    !memcmp(root_key_hash_cache.pubkey_y, pubkey_y, digest_length)) {
+		k_mutex_unlock(&root_key_hash_cache_mutex);
+		return Success;
+	}
+	if (root_key_hash_cache.ufm_valid) {
+		memcpy(ufm_sha_data, root_key_hash_cache.ufm_sha_data, digest_length);
+		cached = true;
+	}
+	k_mutex_unlock(&root_key_hash_cache_mutex);
+#endif
+
 	// Changing little endianess
 	for (i = 0; i < digest_length; i++) {
 		root_public_key[i] = pubkey_x[digest_length - 1 - i];
@@ -51,12 +96,32 @@ int verify_root_key_hash(struct pfr_manifest *manifest, uint8_t *pubkey_x, uint8
 		return Failure;
 	}
 
+#if defined(CONFIG_PFR_ROOT_KEY_HASH_CACHE)
+	if (!cached) {
+		// Read the whole root key hash item from provisoned UFM 0
+		status = ufm_read(PROVISION_UFM, ROOT_KEY_HASH, ufm_sha_data, sizeof(ufm_sha_data));
+		if (status != Success) {
+			LOG_ERR("Block1 Root Entry: Read hash from UFM failed");
+			return status;
+		}
+
+		k_mutex_lock(&root_key_hash_cache_mutex, K_FOREVER);
+		if (root_key_hash_cache.generation != generation) {
+			root_key_hash_cache.generation = generation;
+			root_key_hash_cache.key_valid = false;
+		}
+		memcpy(root_key_hash_cache.ufm_sha_data, ufm_sha_data, sizeof(ufm_sha_data));
+		root_key_hash_cache.ufm_valid = true;
+		k_mutex_unlock(&root_key_hash_cache_mutex);
+	}
+#else
 	// Read hash from provisoned UFM 0
 	status = ufm_read(PROVISION_UFM, ROOT_KEY_HASH, ufm_sha_data, digest_length);
 	if (status != Success) {
 		LOG_ERR("Block1 Root Entry: Read hash from UFM failed");
 		return status;
 	}
+#endif
 
 	if (memcmp(sha_buffer, ufm_sha_data, digest_length)) {
 		LOG_ERR("Block1 Root Entry: hash not matched");
@@ -66,6 +131,17 @@ int verify_root_key_hash(struct pfr_manifest *manifest, uint8_t *pubkey_x, uint8
 		return Failure;
 	}
 
+#if defined(CONFIG_PFR_ROOT_KEY_HASH_CACHE)
+	k_mutex_lock(&root_key_hash_cache_mutex, K_FOREVER);
+	if (root_key_hash_cache.generation == generation) {
+		root_key_hash_cache.hash_curve = manifest->hash_curve;
+		memcpy(root_key_hash_cache.pubkey_x, pubkey_x, digest_length);
+		memcpy(root_key_hash_cache.pubkey_y, pubkey_y, digest_length);
+		root_key_hash_cache.key_valid = true;
+	}
+	k_mutex_unlock(&root_key_hash_cache_mutex);
+#endif
+
 	return Success;
 }
 
@@ -58,7 +58,6 @@ void apply_pfm_protection(int spi_device_id)
 	status = initializeEngines();
 	status = initializeManifestProcessor();
 
-	uint8_t pfm_length[4];
 	uint32_t pfm_read_address = 0;
 
 	if (spi_id == BMC_SPI)
@@ -70,52 +69,36 @@ void apply_pfm_protection(int spi_device_id)
 		return;
 	}
 
-	// Block 0 + Block 1 = 1024 (0x400); PFM data(PFM Body = 0x20)
-	uint32_t pfm_region_Start = pfm_read_address + 0x400 + 0x20;
-	int default_region_length = 40;
+	const struct pfm_index *index;
+	const struct pfm_index_entry *entry;
+	struct pfm_index_iter iter;
+	const PFM_SPI_DEFINITION *spi_def;
+	const PFM_SMBUS_RULE *smbus_rule;
 	uint32_t region_start_address;
 	uint32_t region_end_address;
-	// Table 2-14  get Length
-	uint32_t addr_size_of_pfm = pfm_read_address + 0x400 + 0x1c;
 	int region_length;
 	// cerberus define region_id start from 1
 	int region_id = 1;
-	uint8_t region_record[40];
-#if defined(CONFIG_SEAMLESS_UPDATE)
-	PFM_FVM_ADDRESS_DEFINITION *fvm_def;
-#endif
 
 #if defined(CONFIG_BMC_DUAL_FLASH) || defined(CONFIG_CPU_DUAL_FLASH)
 	int flash_size;
 #endif
 
 	// assign the flash device id,  0:spi1_cs0, 1:spi2_cs0 , 2:spi2_cs1, 3:spi2_cs2, 4:fmc_cs0, 5:fmc_cs1
-	pfr_spi_read(spi_device_id, addr_size_of_pfm, 4, pfm_length);
-
-	int pfm_record_length = (pfm_length[0] & 0xff) | (pfm_length[1] << 8 & 0xff00) | (pfm_length[2] << 16 & 0xff0000) | (pfm_length[3] << 24 & 0xff000000);
+	if (pfm_index_get(spi_device_id, pfm_read_address, PFM_INDEX_PFM, &index)) {
+		LOG_ERR("Failed to read active PFM of SPI_ID[%d]", spi_device_id);
+		return;
+	}
 
-	bool done = false;
 	// TODO: Clear all setting before apply new setting
 
-	while (!done) {
-		/* Read PFM Record */
-		pfr_spi_read(spi_device_id, pfm_region_Start, default_region_length, region_record);
-		switch(region_record[0]) {
+	pfm_index_iter_init(&iter, index);
+	while ((entry = pfm_index_next(&iter)) != NULL) {
+		switch (entry->type) {
 		case SPI_REGION:
-			/* SPI Region: 0x01 */
-			/* Region protect level mask:
-			 * 0b00000001: Protect: Read allowed
-			 * 0b00000010: Protect: Write allowed
-			 * 0b00000100: Recover: recover on first recovery
-			 * 0b00001000: Recover: recover on second recovery
-			 * 0b00010000: Recover: Recover on third recovery
-			 * 0b11100000: Reserved
-			 */
-
-			region_start_address = (region_record[8] & 0xff) | (region_record[9] << 8 & 0xff00) |
-				(region_record[10] << 16 & 0xff0000) | (region_record[11] << 24 & 0xff000000);
-			region_end_address = (region_record[12] & 0xff) | (region_record[13] << 8 & 0xff00) |
-				(region_record[14] << 16 & 0xff0000) | (region_record[15] << 24 & 0xff000000);
+			spi_def = &entry->spi.def;
+			region_start_address = spi_def->RegionStartAddress;
+			region_end_address = spi_def->RegionEndAddress;
 
 #if defined(CONFIG_BMC_DUAL_FLASH)
 			if (spi_device_id == BMC_SPI) {
@@ -126,6 +109,7 @@ void apply_pfm_protection(int spi_device_id)
 					spi_id = spi_device_id + 1;
 				} else if (region_start_address < flash_size && (region_end_address - 1) >= flash_size) {
 					LOG_ERR("ERROR: region start and end address should be in the same flash");
+					pfm_index_put(index);
 					return;
 				} else {
 					spi_id = spi_device_id;
@@ -142,6 +126,7 @@ void apply_pfm_protection(int spi_device_id)
 					spi_id = spi_device_id + 1;
 				} else if (region_start_address < flash_size && (region_end_address - 1) >= flash_size) {
 					LOG_ERR("ERROR: region start and end address should be in the same flash");
+					pfm_index_put(index);
 					return;
 				} else {
 					spi_id = spi_device_id;
@@ -151,7 +136,7 @@ void apply_pfm_protection(int spi_device_id)
 
 			spi_filter->dev_id = spi_id;
 			region_length = region_end_address - region_start_address;
-			if (region_record[1] & 0x02) {
+			if (spi_def->ProtectLevelMask.WriteAllowed) {
 				/* Write allowed region */
 				spi_filter->base.set_filter_rw_region(&spi_filter->base,
 						region_id, region_start_address, region_end_address);
@@ -168,7 +153,7 @@ void apply_pfm_protection(int spi_device_id)
 					spi_id, region_start_address, region_end_address);
 			}
 
-			if (region_record[1] & 0x01) {
+			if (spi_def->ProtectLevelMask.ReadAllowed) {
 				/* Read allowed region */
 				// Cerberus did not support read disabled
 				Set_SPI_Filter_RW_Region((char *)spim_devs[spi_id],
@@ -185,21 +170,6 @@ void apply_pfm_protection(int spi_device_id)
 				LOG_INF("SPI_ID[%d] read  disable 0x%08x to 0x%08x",
 					spi_id, region_start_address, region_end_address);
 			}
-
-			/* Hash Algorhtm 2 bytes:
-			 * 0b00000001: SHA256 present
-			 * 0b00000010: SHA384 present
-			 * 0b00000100: SHA512 present
-			 * Otherwise: Reserved
-			 */
-			if (region_record[2] & 0x01)
-				pfm_region_Start = pfm_region_Start + 48;
-			else if (region_record[2] & 0x02)
-				pfm_region_Start = pfm_region_Start + 64;
-			else if (region_record[2] & 0x04)
-				pfm_region_Start = pfm_region_Start + 80;
-			else
-				pfm_region_Start = pfm_region_Start + 16;
 			break;
 		case SMBUS_RULE:
 			if (!i2c_flt_init) {
@@ -207,15 +177,16 @@ void apply_pfm_protection(int spi_device_id)
 				i2c_flt_init = true;
 			}
 			/* SMBus Rule Definition: 0x02 */
+			smbus_rule = &entry->smbus;
 			LOG_INF("SMBus Rule Bus[%d] RuleId[%d] DeviceAddr[%x]",
-					region_record[5], region_record[6], region_record[7]);
-			LOG_HEXDUMP_INF(&region_record[8], 32, "Whitelist: ");
+					smbus_rule->BusId, smbus_rule->RuleID, smbus_rule->DeviceAddress);
+			LOG_HEXDUMP_INF(smbus_rule->CmdPasslist, 32, "Whitelist: ");
 
-			if (region_record[5] > 0 && region_record[5] < 6 && region_record[6] > 0 && region_record[6] < 17) {
+			if (smbus_rule->BusId > 0 && smbus_rule->BusId < 6 && smbus_rule->RuleID > 0 && smbus_rule->RuleID < 17) {
 				// Valid Bus ID should be 1~5 and reflect to I2C_FILTER_0 ~ I2C_FILTER_4
 				// Valid Rule ID should be 1~16 and refect to I2C Filter Driver Rule 0~15
 
-				bus_dev_name[11] = (region_record[5] - 1) + '0';
+				bus_dev_name[11] = (smbus_rule->BusId - 1) + '0';
 				flt_dev = device_get_binding(bus_dev_name);
 				if (flt_dev) {
 					status = ast_i2c_filter_en(
@@ -227,38 +198,31 @@ void apply_pfm_protection(int spi_device_id)
 					LOG_DBG("ast_i2c_filter_en ret=%d", status);
 					// The i2c device address in the manifest is 8-bit format.
 					// It should be 7-bit format for i2c filter api.
-					uint8_t slave_addr = region_record[7] >> 1;
+					uint8_t slave_addr = smbus_rule->DeviceAddress >> 1;
 					status = ast_i2c_filter_update(
 							flt_dev,
-							region_record[6] - 1, // Rule ID
+							smbus_rule->RuleID - 1, // Rule ID
 							slave_addr,           // Device Address
-							(struct ast_i2c_f_bitmap *)&region_record[8]     // cmd_whitelist
+							(struct ast_i2c_f_bitmap *)smbus_rule->CmdPasslist     // cmd_whitelist
 							);
 					LOG_DBG("ast_i2c_filter_update ret=%d", status);
 				} else {
 					LOG_ERR("%s device not found", bus_dev_name);
 				}
 			} else {
-				LOG_HEXDUMP_ERR(region_record, 40, "Invalid Bus ID or Rule ID");
+				LOG_HEXDUMP_ERR(smbus_rule, sizeof(PFM_SMBUS_RULE), "Invalid Bus ID or Rule ID");
 			}
-
-			pfm_region_Start += sizeof(PFM_SMBUS_RULE);
 			break;
 #if defined(CONFIG_SEAMLESS_UPDATE)
 		case FVM_ADDR_DEF:
-			fvm_def = (PFM_FVM_ADDRESS_DEFINITION *)region_record;
-			apply_fvm_spi_protection(fvm_def->FVMAddress);
-			pfm_region_Start += sizeof(PFM_FVM_ADDRESS_DEFINITION);
+			apply_fvm_spi_protection(entry->fvm.FVMAddress);
 			break;
 #endif
 		default:
-			done = true;
 			break;
 		}
-		if (pfm_region_Start >= pfm_read_address + 0x400 + pfm_record_length)
-			break;
 	}
 
+	pfm_index_put(index);
 	spi_filter->base.enable_filter((struct spi_filter_interface *)spi_filter, true);
 }
-
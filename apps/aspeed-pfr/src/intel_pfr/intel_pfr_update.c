@@ -873,9 +873,11 @@ int perform_seamless_update(uint32_t image_type, void *AoData, void *EventContex
 	LOG_INF("Switch PCH SPI MUX to ROT");
 	dev_m = device_get_binding(PCH_SPI_MONITOR);
 	spim_ext_mux_config(dev_m, SPIM_EXT_MUX_ROT);
+	flash_write_generation_bump(PCH_SPI);
 #if defined(CONFIG_CPU_DUAL_FLASH)
 	dev_m = device_get_binding(PCH_SPI_MONITOR_2);
 	spim_ext_mux_config(dev_m, SPIM_EXT_MUX_ROT);
+	flash_write_generation_bump(PCH_SPI);
 #endif
 
 	if (cpld_update_status.BmcToPchStatus == 1) {
@@ -902,6 +904,7 @@ int perform_seamless_update(uint32_t image_type, void *AoData, void *EventContex
 		dev_m = device_get_binding(BMC_SPI_MONITOR);
 #endif
 		spim_ext_mux_config(dev_m, SPIM_EXT_MUX_ROT);
+		flash_write_generation_bump(BMC_SPI);
 
 		pfr_manifest->address = address;
 
@@ -918,6 +921,7 @@ int perform_seamless_update(uint32_t image_type, void *AoData, void *EventContex
 		// PCH SPI will be release after firmware update completed.
 		LOG_INF("Switch BMC SPI MUX to BMC");
 		spim_ext_mux_config(dev_m, SPIM_EXT_MUX_BMC_PCH);
+		flash_write_generation_bump(BMC_SPI);
 	}
 
 
@@ -948,13 +952,16 @@ release_both_muxes:
 	dev_m = device_get_binding(BMC_SPI_MONITOR);
 #endif
 	spim_ext_mux_config(dev_m, SPIM_EXT_MUX_BMC_PCH);
+	flash_write_generation_bump(BMC_SPI);
 release_pch_mux:
 	LOG_INF("Switch PCH SPI MUX to PCH");
 	dev_m = device_get_binding(PCH_SPI_MONITOR);
 	spim_ext_mux_config(dev_m, SPIM_EXT_MUX_BMC_PCH);
+	flash_write_generation_bump(PCH_SPI);
 #if defined(CONFIG_CPU_DUAL_FLASH)
 	dev_m = device_get_binding(PCH_SPI_MONITOR_2);
 	spim_ext_mux_config(dev_m, SPIM_EXT_MUX_BMC_PCH);
+	flash_write_generation_bump(PCH_SPI);
 #endif
 
 	return status;
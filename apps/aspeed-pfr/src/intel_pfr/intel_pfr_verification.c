@@ -500,6 +500,42 @@ int intel_block1_verify(struct pfr_manifest *manifest)
 	return Success;
 }
 
+#if defined(CONFIG_PFR_NESTED_MANIFEST_HASH)
+/*
+ * Update and recovery capsules start their protected content with a signed PFM (FVM for seamless
+ * capsules, AFM for AFM capsules) which is verified right after the capsule. Find the protected
+ * content of that manifest so that both can be hashed in one pass.
+ */
+static bool intel_get_nested_manifest(struct pfr_manifest *manifest, uint32_t *address,
+		uint32_t *length)
+{
+	PFR_AUTHENTICATION_BLOCK0 block0;
+	uint32_t pc_address = manifest->pfr_hash->start_address;
+	uint32_t pc_length = manifest->pfr_hash->length;
+
+	if (manifest->pc_type != PFR_BMC_UPDATE_CAPSULE &&
+	    manifest->pc_type != PFR_PCH_UPDATE_CAPSULE &&
+	    manifest->pc_type != PFR_PCH_SEAMLESS_UPDATE_CAPSULE &&
+	    manifest->pc_type != PFR_AFM)
+		return false;
+
+	if (pc_length < PFM_SIG_BLOCK_SIZE)
+		return false;
+
+	if (pfr_spi_read(manifest->image_type, pc_address, sizeof(block0), (uint8_t *)&block0))
+		return false;
+
+	if (block0.Block0Tag != BLOCK0TAG || block0.PcLength < 128 || block0.PcLength % 128 ||
+	    block0.PcLength > pc_length - PFM_SIG_BLOCK_SIZE)
+		return false;
+
+	*address = pc_address + PFM_SIG_BLOCK_SIZE;
+	*length = block0.PcLength;
+
+	return true;
+}
+#endif
+
 // BLOCK 0
 int intel_block0_verify(struct pfr_manifest *manifest)
 {
@@ -507,6 +543,10 @@ int intel_block0_verify(struct pfr_manifest *manifest)
 	uint8_t sha_buffer[SHA384_DIGEST_LENGTH] = { 0 };
 	PFR_AUTHENTICATION_BLOCK0 *block0_buffer;
 	uint32_t hash_length = 0;
+#if defined(CONFIG_PFR_NESTED_MANIFEST_HASH)
+	uint32_t nested_address;
+	uint32_t nested_length;
+#endif
 	uint8_t *ptr_sha;
 	int status = 0;
 	int i;
@@ -571,7 +611,14 @@ int intel_block0_verify(struct pfr_manifest *manifest)
 		return Failure;
 	}
 
-	status = manifest->base->get_hash((struct manifest *)manifest, manifest->hash, sha_buffer, hash_length);
+#if defined(CONFIG_PFR_NESTED_MANIFEST_HASH)
+	if (intel_get_nested_manifest(manifest, &nested_address, &nested_length))
+		status = get_hash_nested((struct manifest *)manifest, manifest->hash,
+				nested_address, nested_length, sha_buffer, hash_length);
+	else
+#endif
+		status = manifest->base->get_hash((struct manifest *)manifest, manifest->hash,
+				sha_buffer, hash_length);
 	if (status != Success) {
 		LOG_ERR("Block0: Get hash failed");
 		return Failure;
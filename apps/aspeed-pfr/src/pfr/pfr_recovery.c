@@ -233,6 +233,17 @@ int pfr_recover_recovery_region(int image_type, uint32_t source_address, uint32_
 	LOG_INF("Recovering...");
 	LOG_INF("image_type=%d, source_address=%x, target_address=%x, length=%x",
 		image_type, source_address, target_address, area_size);
+#if defined(CONFIG_PFR_SPI_DIFF_COPY)
+	uint32_t written_sectors;
+
+	ARG_UNUSED(support_block_erase);
+	if (pfr_spi_region_diff_copy(image_type, source_address,
+				image_type, target_address, area_size, &written_sectors)) {
+		LOG_ERR("Recovery region update failed");
+		return Failure;
+	}
+	LOG_INF("%d of %d sectors rewritten", written_sectors, area_size / SECTOR_SIZE);
+#else
 	if (pfr_spi_erase_region(image_type, support_block_erase, target_address, area_size)) {
 		LOG_ERR("Recovery region erase failed");
 		return Failure;
@@ -244,6 +255,7 @@ int pfr_recover_recovery_region(int image_type, uint32_t source_address, uint32_
 		LOG_ERR("Recovery region update failed");
 		return Failure;
 	}
+#endif
 
 	LOG_INF("Recovery region update completed");
 
@@ -76,9 +76,13 @@ int ufm_write(uint32_t ufm_id, uint32_t offset, uint8_t *data, uint32_t data_len
 
 int ufm_erase(uint32_t ufm_id)
 {
-	if (ufm_id == PROVISION_UFM)
-		return pfr_spi_erase_4k(ROT_INTERNAL_INTEL_STATE, 0);
-	else if (ufm_id == UPDATE_STATUS_UFM)
+	int status;
+
+	if (ufm_id == PROVISION_UFM) {
+		status = pfr_spi_erase_4k(ROT_INTERNAL_INTEL_STATE, 0);
+		provision_data_changed();
+		return status;
+	} else if (ufm_id == UPDATE_STATUS_UFM)
 		return pfr_spi_erase_4k(ROT_INTERNAL_STATE, 0);
 	else
 		return Failure;
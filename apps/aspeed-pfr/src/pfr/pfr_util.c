@@ -31,6 +31,8 @@
 #include "cerberus_pfr/cerberus_pfr_definitions.h"
 #endif
 #include "crypto/ecdsa_aspeed.h"
+#include "crypto/hash_aspeed.h"
+#include <zephyr.h>
 #include <sys/reboot.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -98,25 +100,96 @@ int pfr_spi_erase_block(uint8_t device_id, uint32_t address)
 	return status;
 }
 
+static int pfr_spi_erase_by_cmd(uint8_t device_id, uint32_t address, uint32_t size, uint8_t cmd)
+{
+	if (device_id <= PCH_SPI)
+		return bmc_pch_flash_erase_by_cmd(device_id, address, size, cmd);
+
+	return rot_flash_erase_by_cmd(device_id, address, size, cmd);
+}
+
+/**
+ * Pick the next erase operation of an erase plan.
+ *
+ * Erase sizes are nested powers of two, so taking the largest supported erase which is aligned
+ * at addr and fits before end_addr yields the minimal number of erase commands.
+ *
+ * @param addr current erase address
+ * @param end_addr end of the range to erase
+ * @param erase_caps bitmask of PFR_ERASE_CAP_* supported by the device
+ * @param size output for the number of bytes covered by the returned command
+ *
+ * @return erase opcode to issue at addr
+ */
+uint8_t pfr_spi_erase_plan_next(uint32_t addr, uint32_t end_addr, uint8_t erase_caps,
+		uint32_t *size)
+{
+	uint32_t remaining = end_addr - addr;
+
+	if ((erase_caps & PFR_ERASE_CAP_64K) && !(addr % BLOCK_SIZE) && remaining >= BLOCK_SIZE) {
+		*size = BLOCK_SIZE;
+		return MIDLEY_FLASH_CMD_BLOCK_ERASE;
+	}
+
+	if ((erase_caps & PFR_ERASE_CAP_32K) && !(addr % BLOCK_32K_SIZE) &&
+	    remaining >= BLOCK_32K_SIZE) {
+		*size = BLOCK_32K_SIZE;
+		return MIDLEY_FLASH_CMD_32K_ERASE;
+	}
+
+	*size = SECTOR_SIZE;
+	return MIDLEY_FLASH_CMD_4K_ERASE;
+}
+
 int pfr_spi_erase_region(uint8_t device_id,
 		bool support_block_erase, uint32_t start_addr, uint32_t nbytes)
 {
 	uint32_t erase_addr = start_addr;
 	uint32_t end_addr = start_addr + nbytes;
+	uint8_t erase_caps = 0;
+	uint32_t run_addr = 0;
+	uint32_t run_size = 0;
+	uint8_t run_cmd = 0;
+	uint32_t op_size;
+	uint8_t cmd;
 
+	// Block erases are used only if the caller allows them and the flash part supports them
+	if (support_block_erase) {
+		if (get_erase_size(device_id, MIDLEY_FLASH_CMD_BLOCK_ERASE) == BLOCK_SIZE)
+			erase_caps |= PFR_ERASE_CAP_64K;
+		if (get_erase_size(device_id, MIDLEY_FLASH_CMD_32K_ERASE) == BLOCK_32K_SIZE)
+			erase_caps |= PFR_ERASE_CAP_32K;
+	}
+
+	// Consecutive operations with the same opcode are handed to the driver in one call
 	while (erase_addr < end_addr) {
-		if (support_block_erase && ((end_addr - erase_addr) >= BLOCK_SIZE) &&
-				!(erase_addr & 0xffff)) {
-			if (pfr_spi_erase_block(device_id, erase_addr))
+		cmd = pfr_spi_erase_plan_next(erase_addr, end_addr, erase_caps, &op_size);
+#if defined(CONFIG_PFR_SPI_ERASE_BLANK_CHECK)
+		if (flash_is_blank(device_id, erase_addr, op_size)) {
+			if (run_size && pfr_spi_erase_by_cmd(device_id, run_addr, run_size, run_cmd))
 				return Failure;
-			erase_addr += BLOCK_SIZE;
-		} else {
-			if (pfr_spi_erase_4k(device_id, erase_addr))
+			run_size = 0;
+			erase_addr += op_size;
+			continue;
+		}
+#endif
+		if (run_size && cmd != run_cmd) {
+			if (pfr_spi_erase_by_cmd(device_id, run_addr, run_size, run_cmd))
 				return Failure;
-			erase_addr += PAGE_SIZE;
+			run_size = 0;
 		}
+
+		if (run_size == 0) {
+			run_addr = erase_addr;
+			run_cmd = cmd;
+		}
+		run_size += op_size;
+		erase_addr += op_size;
 	}
 
+	if (run_size && pfr_spi_erase_by_cmd(device_id, run_addr, run_size, run_cmd))
+		return Failure;
+
 	return Success;
 }
 
@@ -153,36 +226,619 @@ int pfr_spi_page_read_write(uint8_t device_id, uint32_t source_address, uint32_t
 	return Success;
 }
 
+/*
+ * Flash to flash copy engine.
+ *
+ * The caller thread reads chunk N+1 from the source device while the copy writer thread
+ * programs chunk N on the destination device, the chunks rotate through
+ * CONFIG_PFR_SPI_COPY_BUF_COUNT DMA-capable buffers.
+ */
+#define SPI_COPY_WRITER_STACK_SIZE 2048
+#define SPI_COPY_WRITER_PRIO 5
+
+struct spi_copy_job {
+	uint8_t *buf;
+	uint32_t addr;
+	uint32_t length;
+	uint8_t dev;
+};
+
+K_THREAD_STACK_DEFINE(spi_copy_writer_stack, SPI_COPY_WRITER_STACK_SIZE);
+static struct k_thread spi_copy_writer_thread;
+K_MSGQ_DEFINE(spi_copy_msgq, sizeof(struct spi_copy_job), CONFIG_PFR_SPI_COPY_BUF_COUNT, 4);
+K_SEM_DEFINE(spi_copy_free_sem, CONFIG_PFR_SPI_COPY_BUF_COUNT, CONFIG_PFR_SPI_COPY_BUF_COUNT);
+K_SEM_DEFINE(spi_copy_done_sem, 0, 1);
+K_MUTEX_DEFINE(spi_copy_mutex);
+static uint8_t spi_copy_buf[CONFIG_PFR_SPI_COPY_BUF_COUNT][CONFIG_PFR_SPI_COPY_CHUNK_SIZE]
+	NON_CACHED_BSS_ALIGN16;
+static bool spi_copy_writer_started;
+static int spi_copy_status;
+
+static void spi_copy_writer(void *a, void *b, void *c)
+{
+	struct spi_copy_job job;
+
+	ARG_UNUSED(a);
+	ARG_UNUSED(b);
+	ARG_UNUSED(c);
+
+	while (1) {
+		k_msgq_get(&spi_copy_msgq, &job, K_FOREVER);
+
+		// Zero length job marks the end of a copy request
+		if (job.length == 0) {
+			k_sem_give(&spi_copy_done_sem);
+			continue;
+		}
+
+		if (spi_copy_status == Success &&
+		    pfr_spi_write(job.dev, job.addr, job.length, job.buf)) {
+			LOG_ERR("Failed to write dev(%d) address(%x) length(%x)",
+					job.dev, job.addr, job.length);
+			spi_copy_status = Failure;
+		}
+
+		k_sem_give(&spi_copy_free_sem);
+	}
+}
+
 int pfr_spi_region_read_write_between_spi(uint8_t src_dev, uint32_t src_addr,
 		uint8_t dest_dev, uint32_t dest_addr, size_t length)
 {
-	static uint8_t buffer[PAGE_SIZE] NON_CACHED_BSS_ALIGN16;
-	int i;
+	struct spi_copy_job job;
+	uint32_t remaining;
+	uint8_t idx = 0;
+	int status;
 
-	for (i = 0; i < length / PAGE_SIZE; i++) {
-		if (pfr_spi_read(src_dev, src_addr, PAGE_SIZE, buffer))
-			return Failure;
-		if (pfr_spi_write(dest_dev, dest_addr, PAGE_SIZE, buffer))
-			return Failure;
+	// Only whole pages are copied
+	remaining = length - (length % PAGE_SIZE);
 
-		src_addr += PAGE_SIZE;
-		dest_addr += PAGE_SIZE;
+	k_mutex_lock(&spi_copy_mutex, K_FOREVER);
+	if (!spi_copy_writer_started) {
+		k_tid_t tid = k_thread_create(&spi_copy_writer_thread, spi_copy_writer_stack,
+				K_THREAD_STACK_SIZEOF(spi_copy_writer_stack), spi_copy_writer,
+				NULL, NULL, NULL, SPI_COPY_WRITER_PRIO, 0, K_NO_WAIT);
+		k_thread_name_set(tid, "SPI COPY");
+		spi_copy_writer_started = true;
 	}
 
-	return Success;
+	spi_copy_status = Success;
+	while (remaining) {
+		k_sem_take(&spi_copy_free_sem, K_FOREVER);
+		if (spi_copy_status != Success) {
+			k_sem_give(&spi_copy_free_sem);
+			break;
+		}
+
+		job.buf = spi_copy_buf[idx];
+		job.dev = dest_dev;
+		job.addr = dest_addr;
+		job.length = MIN(remaining, CONFIG_PFR_SPI_COPY_CHUNK_SIZE);
+		if (pfr_spi_read(src_dev, src_addr, job.length, job.buf)) {
+			LOG_ERR("Failed to read dev(%d) address(%x) length(%x)",
+					src_dev, src_addr, job.length);
+			spi_copy_status = Failure;
+			k_sem_give(&spi_copy_free_sem);
+			break;
+		}
+
+		k_msgq_put(&spi_copy_msgq, &job, K_FOREVER);
+
+		src_addr += job.length;
+		dest_addr += job.length;
+		remaining -= job.length;
+		idx = (idx + 1) % CONFIG_PFR_SPI_COPY_BUF_COUNT;
+	}
+
+	// Wait until the writer drained all queued chunks
+	job.length = 0;
+	k_msgq_put(&spi_copy_msgq, &job, K_FOREVER);
+	k_sem_take(&spi_copy_done_sem, K_FOREVER);
+
+	status = spi_copy_status;
+	k_mutex_unlock(&spi_copy_mutex);
+
+	return status;
 }
 
-// Calculate hash digest
-int get_hash(struct manifest *manifest, struct hash_engine *hash_engine, uint8_t *hash_out, size_t hash_length)
+#if defined(CONFIG_PFR_SPI_DIFF_COPY)
+/**
+ * Copy a region between flashes, skipping sectors whose destination content already matches
+ * the source. Differing sectors are erased (unless already blank) and programmed, so unlike
+ * pfr_spi_region_read_write_between_spi the destination does not need to be erased beforehand.
+ *
+ * @param src_dev source device id
+ * @param src_addr source address, 4KB aligned
+ * @param dest_dev destination device id
+ * @param dest_addr destination address, 4KB aligned
+ * @param length number of bytes to copy, multiple of 4KB
+ * @param written_sectors optional output for the number of sectors that were rewritten
+ *
+ * @return Success or Failure
+ */
+int pfr_spi_region_diff_copy(uint8_t src_dev, uint32_t src_addr,
+		uint8_t dest_dev, uint32_t dest_addr, size_t length, uint32_t *written_sectors)
 {
-	struct pfr_manifest *pfr_manifest = (struct pfr_manifest *)manifest;
+	uint32_t rewritten = 0;
+	uint8_t *src_buf;
+	uint8_t *dest_buf;
+	int status = Success;
 
-	if (pfr_manifest == NULL || hash_engine == NULL ||
-	    hash_out == NULL || hash_length < SHA256_HASH_LENGTH ||
-	    (hash_length > SHA256_HASH_LENGTH && hash_length < SHA384_HASH_LENGTH)) {
+	if ((src_addr | dest_addr | length) % SECTOR_SIZE) {
+		LOG_ERR("Differential copy requires 4KB aligned regions");
 		return Failure;
 	}
 
+	src_buf = flash_dma_buf_alloc(SECTOR_SIZE);
+	dest_buf = flash_dma_buf_alloc(SECTOR_SIZE);
+	if (src_buf == NULL || dest_buf == NULL) {
+		LOG_ERR("Failed to allocate differential copy buffers");
+		status = Failure;
+		goto free_buf;
+	}
+
+	while (length) {
+		if (pfr_spi_read(src_dev, src_addr, SECTOR_SIZE, src_buf) ||
+		    pfr_spi_read(dest_dev, dest_addr, SECTOR_SIZE, dest_buf)) {
+			status = Failure;
+			break;
+		}
+
+		if (memcmp(src_buf, dest_buf, SECTOR_SIZE)) {
+			if (!flash_buf_is_blank(dest_buf, SECTOR_SIZE) &&
+			    pfr_spi_erase_4k(dest_dev, dest_addr)) {
+				status = Failure;
+				break;
+			}
+
+			if (!flash_buf_is_blank(src_buf, SECTOR_SIZE) &&
+			    pfr_spi_write(dest_dev, dest_addr, SECTOR_SIZE, src_buf)) {
+				status = Failure;
+				break;
+			}
+			rewritten++;
+		}
+
+		src_addr += SECTOR_SIZE;
+		dest_addr += SECTOR_SIZE;
+		length -= SECTOR_SIZE;
+	}
+
+	if (status != Success)
+		LOG_ERR("Differential copy failed at dev(%d) address(%x)", dest_dev, dest_addr);
+
+	if (written_sectors)
+		*written_sectors = rewritten;
+
+free_buf:
+	flash_dma_buf_free(src_buf);
+	flash_dma_buf_free(dest_buf);
+
+	return status;
+}
+#endif
+
+#if defined(CONFIG_PFR_SPI_HASH_STREAM)
+struct pfr_spi_hash_cursor {
+	const struct pfr_spi_extent *extent;
+	size_t count;
+	uint32_t offset;
+};
+
+/* Queue the read of the next chunk, chunks never span two extents. Returns the chunk length or 0
+ * when every extent has been read.
+ */
+static uint32_t pfr_spi_hash_read_next(struct pfr_spi_hash_cursor *cursor, struct flash_req *req,
+		uint8_t *buf)
+{
+	uint32_t length;
+
+	while (cursor->count && cursor->offset == cursor->extent->length) {
+		cursor->extent++;
+		cursor->count--;
+		cursor->offset = 0;
+	}
+
+	if (!cursor->count)
+		return 0;
+
+	length = MIN(cursor->extent->length - cursor->offset, CONFIG_PFR_SPI_HASH_CHUNK_SIZE);
+	req->op = FLASH_REQ_READ;
+	req->device_id = cursor->extent->device_id;
+	req->address = cursor->extent->address + cursor->offset;
+	req->length = length;
+	req->data = buf;
+	if (flash_req_submit(req))
+		req->result = Failure;
+	cursor->offset += length;
+
+	return length;
+}
+
+static int pfr_spi_hash_read_wait(struct flash_req *req)
+{
+	if (req->result != -EINPROGRESS)
+		return req->result;
+
+	return flash_req_wait(req, K_FOREVER);
+}
+
+/*
+ * A region nested in the streamed extents which is also hashed into a second session, either as
+ * a whole or, when chunk_size is set, as consecutive chunk_size digests written to chunk_hash_out.
+ * The nested region must be streamed in order.
+ */
+struct pfr_spi_hash_nested {
+	struct hash_session *session;
+	enum hash_algo algo;
+	uint8_t device_id;
+	uint32_t address;
+	uint32_t length;
+	uint32_t chunk_size;
+	uint8_t *chunk_hash_out;
+	size_t chunk_hash_length;
+	uint32_t offset;
+};
+
+static int pfr_spi_hash_nested_update(struct pfr_spi_hash_nested *nested,
+		const struct flash_req *req, const uint8_t *buf, uint32_t length)
+{
+	uint32_t start;
+	uint32_t end;
+	uint32_t size;
+	int status;
+
+	if (nested == NULL || req->device_id != nested->device_id)
+		return 0;
+
+	start = MAX(req->address, nested->address);
+	end = MIN(req->address + length, nested->address + nested->length);
+	if (start >= end)
+		return 0;
+
+	buf += start - req->address;
+	length = end - start;
+	if (!nested->chunk_size)
+		return hash_engine_session_update(nested->session, buf, length);
+
+	while (length) {
+		size = MIN(length, nested->chunk_size - (nested->offset % nested->chunk_size));
+		status = hash_engine_session_update(nested->session, buf, size);
+		if (status)
+			return status;
+
+		buf += size;
+		length -= size;
+		nested->offset += size;
+		if ((nested->offset % nested->chunk_size) && nested->offset != nested->length)
+			continue;
+
+		// End of a chunk, the last one may be short
+		status = hash_engine_session_finish(nested->session, nested->chunk_hash_out,
+				nested->chunk_hash_length);
+		nested->session = NULL;
+		if (status)
+			return status;
+
+		nested->chunk_hash_out += nested->chunk_hash_length;
+		if (nested->offset < nested->length) {
+			status = hash_engine_session_start(nested->algo, &nested->session);
+			if (status)
+				return status;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Stream the extents, in order, into session and the part of them covered by nested, if any,
+ * into the nested session. The extents are read through two DMA buffers: the next chunk is read
+ * from flash, across extent boundaries, while the hash engine consumes the current one.
+ *
+ * The sessions are left open for the caller to finish or cancel.
+ */
+static int pfr_spi_hash_stream(const struct pfr_spi_extent *extents, size_t count,
+		struct hash_session *session, struct pfr_spi_hash_nested *nested)
+{
+	struct pfr_spi_hash_cursor cursor = { extents, count, 0 };
+	struct k_poll_signal signal[2];
+	struct flash_req req[2];
+	uint8_t *buf[2];
+	uint32_t chunk[2];
+	uint8_t cur = 0;
+	int status = 0;
+
+	buf[0] = flash_dma_buf_alloc(CONFIG_PFR_SPI_HASH_CHUNK_SIZE);
+	buf[1] = flash_dma_buf_alloc(CONFIG_PFR_SPI_HASH_CHUNK_SIZE);
+	if (buf[0] == NULL || buf[1] == NULL) {
+		status = -ENOMEM;
+		goto free_buf;
+	}
+
+	memset(req, 0, sizeof(req));
+	k_poll_signal_init(&signal[0]);
+	k_poll_signal_init(&signal[1]);
+	req[0].signal = &signal[0];
+	req[1].signal = &signal[1];
+
+	chunk[cur] = pfr_spi_hash_read_next(&cursor, &req[cur], buf[cur]);
+	while (chunk[cur]) {
+		status = pfr_spi_hash_read_wait(&req[cur]);
+		if (status)
+			break;
+
+		chunk[!cur] = pfr_spi_hash_read_next(&cursor, &req[!cur], buf[!cur]);
+		status = hash_engine_session_update(session, buf[cur], chunk[cur]);
+		if (!status)
+			status = pfr_spi_hash_nested_update(nested, &req[cur], buf[cur], chunk[cur]);
+		if (status) {
+			// The read of the next chunk is still in flight
+			if (chunk[!cur])
+				pfr_spi_hash_read_wait(&req[!cur]);
+			break;
+		}
+		cur = !cur;
+	}
+
+	if (status)
+		LOG_ERR("Hash region failed at dev(%d) address(%x)", req[cur].device_id,
+				req[cur].address);
+
+free_buf:
+	flash_dma_buf_free(buf[0]);
+	flash_dma_buf_free(buf[1]);
+
+	return status;
+}
+
+/**
+ * Hash a list of flash extents, in order, in a single hash session.
+ *
+ * @return 0 if the digest was calculated, -ENOMEM if no DMA buffer was available or an error
+ * code.
+ */
+int pfr_spi_hash_extents(const struct pfr_spi_extent *extents, size_t count,
+		enum hash_algo algo, uint8_t *hash_out, size_t hash_length)
+{
+	struct hash_session *session;
+	int status;
+
+	status = hash_engine_session_start(algo, &session);
+	if (status)
+		return status;
+
+	status = pfr_spi_hash_stream(extents, count, session, NULL);
+	if (status) {
+		hash_engine_session_cancel(session);
+		return status;
+	}
+
+	return hash_engine_session_finish(session, hash_out, hash_length);
+}
+
+int pfr_spi_hash_region(uint8_t device_id, uint32_t address, uint32_t length,
+		enum hash_algo algo, uint8_t *hash_out, size_t hash_length)
+{
+	struct pfr_spi_extent extent = { device_id, address, length };
+
+	return pfr_spi_hash_extents(&extent, 1, algo, hash_out, hash_length);
+}
+
+/**
+ * Hash a flash region and a region nested in it with a single read of the flash.
+ *
+ * The outer digest normally runs on the hash engine while the nested one, which starts while the
+ * engine is owned, is computed in software from the same buffers.
+ *
+ * @return 0 if both digests were calculated, -ENOMEM if no DMA buffer or hash session was
+ * available or an error code.
+ */
+int pfr_spi_hash_region_nested(uint8_t device_id, uint32_t address, uint32_t length,
+		uint32_t nested_address, uint32_t nested_length, enum hash_algo algo,
+		uint8_t *hash_out, uint8_t *nested_hash_out, size_t hash_length)
+{
+	struct pfr_spi_extent extent = { device_id, address, length };
+	struct pfr_spi_hash_nested nested = {
+		.algo = algo,
+		.device_id = device_id,
+		.address = nested_address,
+		.length = nested_length,
+	};
+	struct hash_session *session;
+	int status;
+
+	if (nested_address < address || nested_length > length ||
+	    nested_address - address > length - nested_length)
+		return -EINVAL;
+
+	status = hash_engine_session_start(algo, &session);
+	if (status)
+		return status;
+
+	status = hash_engine_session_start(algo, &nested.session);
+	if (status) {
+		hash_engine_session_cancel(session);
+		return status;
+	}
+
+	status = pfr_spi_hash_stream(&extent, 1, session, &nested);
+	if (status) {
+		hash_engine_session_cancel(nested.session);
+		hash_engine_session_cancel(session);
+		return status;
+	}
+
+	status = hash_engine_session_finish(nested.session, nested_hash_out, hash_length);
+	if (status) {
+		hash_engine_session_cancel(session);
+		return status;
+	}
+
+	return hash_engine_session_finish(session, hash_out, hash_length);
+}
+
+/**
+ * Hash a flash region and, from the same flash reads, every chunk_size chunk of it into
+ * chunk_hash_out, one chunk_hash_length digest per chunk. The last chunk may be shorter.
+ *
+ * @return 0 if all digests were calculated, -ENOMEM if no DMA buffer or hash session was
+ * available or an error code.
+ */
+int pfr_spi_hash_region_chunked(uint8_t device_id, uint32_t address, uint32_t length,
+		enum hash_algo algo, uint8_t *hash_out, size_t hash_length, uint32_t chunk_size,
+		enum hash_algo chunk_algo, uint8_t *chunk_hash_out, size_t chunk_hash_length)
+{
+	struct pfr_spi_extent extent = { device_id, address, length };
+	struct pfr_spi_hash_nested nested = {
+		.algo = chunk_algo,
+		.device_id = device_id,
+		.address = address,
+		.length = length,
+		.chunk_size = chunk_size,
+		.chunk_hash_out = chunk_hash_out,
+		.chunk_hash_length = chunk_hash_length,
+	};
+	struct hash_session *session;
+	int status;
+
+	if (!chunk_size || !length)
+		return -EINVAL;
+
+	status = hash_engine_session_start(algo, &session);
+	if (status)
+		return status;
+
+	status = hash_engine_session_start(chunk_algo, &nested.session);
+	if (status) {
+		hash_engine_session_cancel(session);
+		return status;
+	}
+
+	// The chunk sessions are finished as the stream crosses the chunk boundaries
+	status = pfr_spi_hash_stream(&extent, 1, session, &nested);
+	if (status) {
+		hash_engine_session_cancel(nested.session);
+		hash_engine_session_cancel(session);
+		return status;
+	}
+
+	return hash_engine_session_finish(session, hash_out, hash_length);
+}
+#endif
+
+#if defined(CONFIG_PFR_REGION_HASH_CACHE)
+/**
+ * Region digests are remembered together with the write generation of their flash device at the
+ * time the region was read. Any write or erase on the device, or handing it back to the BMC or
+ * PCH, changes the generation and makes the entry stale.
+ */
+struct pfr_region_hash_entry {
+	bool valid;
+	uint8_t device_id;
+	uint32_t type;
+	uint32_t address;
+	uint32_t length;
+	uint32_t generation;
+	uint32_t last_used;
+	uint8_t digest[SHA384_HASH_LENGTH];
+};
+
+static struct pfr_region_hash_entry pfr_region_hash_cache[CONFIG_PFR_REGION_HASH_CACHE_SIZE];
+static uint32_t pfr_region_hash_clock;
+static K_MUTEX_DEFINE(pfr_region_hash_mutex);
+
+static size_t pfr_region_hash_digest_length(uint32_t type)
+{
+	if (type == HASH_TYPE_SHA256)
+		return SHA256_HASH_LENGTH;
+	if (type == HASH_TYPE_SHA384)
+		return SHA384_HASH_LENGTH;
+
+	return 0;
+}
+
+static bool pfr_region_hash_lookup(uint8_t device_id, uint32_t type, uint32_t address,
+		uint32_t length, uint8_t *hash_out)
+{
+	uint32_t generation = flash_write_generation_get(device_id);
+	bool found = false;
+	size_t i;
+
+	k_mutex_lock(&pfr_region_hash_mutex, K_FOREVER);
+	for (i = 0; i < ARRAY_SIZE(pfr_region_hash_cache); i++) {
+		struct pfr_region_hash_entry *entry = &pfr_region_hash_cache[i];
+
+		if (entry->valid && entry->device_id == device_id && entry->type == type &&
+		    entry->address == address && entry->length == length &&
+		    entry->generation == generation) {
+			memcpy(hash_out, entry->digest, pfr_region_hash_digest_length(type));
+			entry->last_used = ++pfr_region_hash_clock;
+			found = true;
+			break;
+		}
+	}
+	k_mutex_unlock(&pfr_region_hash_mutex);
+
+	return found;
+}
+
+/* generation must be sampled before the region is read */
+static void pfr_region_hash_insert(uint8_t device_id, uint32_t type, uint32_t address,
+		uint32_t length, uint32_t generation, const uint8_t *digest)
+{
+	struct pfr_region_hash_entry *entry = &pfr_region_hash_cache[0];
+	size_t i;
+
+	k_mutex_lock(&pfr_region_hash_mutex, K_FOREVER);
+	for (i = 0; i < ARRAY_SIZE(pfr_region_hash_cache); i++) {
+		struct pfr_region_hash_entry *candidate = &pfr_region_hash_cache[i];
+
+		// Reuse the slot of the same region, otherwise the least recently used one
+		if (candidate->valid && candidate->device_id == device_id &&
+		    candidate->type == type && candidate->address == address &&
+		    candidate->length == length) {
+			entry = candidate;
+			break;
+		}
+		if (!candidate->valid)
+			entry = candidate;
+		else if (entry->valid && candidate->last_used < entry->last_used)
+			entry = candidate;
+	}
+
+	entry->device_id = device_id;
+	entry->type = type;
+	entry->address = address;
+	entry->length = length;
+	entry->generation = generation;
+	entry->last_used = ++pfr_region_hash_clock;
+	memcpy(entry->digest, digest, pfr_region_hash_digest_length(type));
+	entry->valid = true;
+	k_mutex_unlock(&pfr_region_hash_mutex);
+}
+#endif
+
+static int get_hash_uncached(struct pfr_manifest *pfr_manifest, uint8_t *hash_out,
+		size_t hash_length)
+{
+#if defined(CONFIG_PFR_SPI_HASH_STREAM)
+	if (pfr_manifest->pfr_hash->type == HASH_TYPE_SHA256 ||
+	    pfr_manifest->pfr_hash->type == HASH_TYPE_SHA384) {
+		int status = pfr_spi_hash_region(pfr_manifest->flash->state->device_id[0],
+				pfr_manifest->pfr_hash->start_address,
+				pfr_manifest->pfr_hash->length,
+				(pfr_manifest->pfr_hash->type == HASH_TYPE_SHA256) ?
+				HASH_SHA256 : HASH_SHA384,
+				hash_out,
+				hash_length);
+
+		// Out of DMA buffers, fall back to the unbuffered path
+		if (status != -ENOMEM)
+			return status;
+	}
+#endif
+
 	return flash_hash_contents((struct flash *)pfr_manifest->flash,
 			pfr_manifest->pfr_hash->start_address,
 			pfr_manifest->pfr_hash->length,
@@ -192,6 +848,489 @@ int get_hash(struct manifest *manifest, struct hash_engine *hash_engine, uint8_t
 			hash_length);
 }
 
+// Calculate hash digest
+int get_hash(struct manifest *manifest, struct hash_engine *hash_engine, uint8_t *hash_out, size_t hash_length)
+{
+	struct pfr_manifest *pfr_manifest = (struct pfr_manifest *)manifest;
+#if defined(CONFIG_PFR_REGION_HASH_CACHE)
+	uint8_t device_id;
+	uint32_t generation;
+	uint32_t type;
+	int status;
+#endif
+
+	if (pfr_manifest == NULL || hash_engine == NULL ||
+	    hash_out == NULL || hash_length < SHA256_HASH_LENGTH ||
+	    (hash_length > SHA256_HASH_LENGTH && hash_length < SHA384_HASH_LENGTH)) {
+		return Failure;
+	}
+
+#if defined(CONFIG_PFR_REGION_HASH_CACHE)
+	device_id = pfr_manifest->flash->state->device_id[0];
+	type = pfr_manifest->pfr_hash->type;
+	if (pfr_region_hash_digest_length(type) == 0 ||
+	    pfr_region_hash_digest_length(type) > hash_length)
+		return get_hash_uncached(pfr_manifest, hash_out, hash_length);
+
+	if (pfr_region_hash_lookup(device_id, type, pfr_manifest->pfr_hash->start_address,
+				pfr_manifest->pfr_hash->length, hash_out))
+		return Success;
+
+	generation = flash_write_generation_get(device_id);
+	status = get_hash_uncached(pfr_manifest, hash_out, hash_length);
+	if (status == Success)
+		pfr_region_hash_insert(device_id, type, pfr_manifest->pfr_hash->start_address,
+				pfr_manifest->pfr_hash->length, generation, hash_out);
+
+	return status;
+#else
+	return get_hash_uncached(pfr_manifest, hash_out, hash_length);
+#endif
+}
+
+#if defined(CONFIG_PFR_NESTED_MANIFEST_HASH)
+/**
+ * Calculate the digest of the manifest hash region like get_hash, together with the digest of a
+ * signed manifest nested in it, such as the PFM at the start of an update capsule, from the same
+ * flash reads. The nested digest is stored in the region hash cache, where the verification of
+ * the nested manifest finds it instead of reading the region again.
+ */
+int get_hash_nested(struct manifest *manifest, struct hash_engine *hash_engine,
+		uint32_t nested_address, uint32_t nested_length, uint8_t *hash_out,
+		size_t hash_length)
+{
+	struct pfr_manifest *pfr_manifest = (struct pfr_manifest *)manifest;
+	uint8_t nested_hash[SHA384_HASH_LENGTH];
+	size_t digest_length;
+	uint32_t generation;
+	uint8_t device_id;
+	uint32_t type;
+	int status;
+
+	if (pfr_manifest == NULL || hash_engine == NULL || hash_out == NULL)
+		return Failure;
+
+	device_id = pfr_manifest->flash->state->device_id[0];
+	type = pfr_manifest->pfr_hash->type;
+	digest_length = pfr_region_hash_digest_length(type);
+
+	// Nothing to share when either digest is already known
+	if (digest_length == 0 || digest_length > hash_length ||
+	    pfr_region_hash_lookup(device_id, type, nested_address, nested_length, nested_hash) ||
+	    pfr_region_hash_lookup(device_id, type, pfr_manifest->pfr_hash->start_address,
+				pfr_manifest->pfr_hash->length, hash_out))
+		return get_hash(manifest, hash_engine, hash_out, hash_length);
+
+	generation = flash_write_generation_get(device_id);
+	status = pfr_spi_hash_region_nested(device_id, pfr_manifest->pfr_hash->start_address,
+			pfr_manifest->pfr_hash->length, nested_address, nested_length,
+			(type == HASH_TYPE_SHA256) ? HASH_SHA256 : HASH_SHA384,
+			hash_out, nested_hash, digest_length);
+
+	// Out of DMA buffers or hash sessions, fall back to hashing the regions one by one
+	if (status == -ENOMEM)
+		return get_hash(manifest, hash_engine, hash_out, hash_length);
+	if (status)
+		return status;
+
+	pfr_region_hash_insert(device_id, type, pfr_manifest->pfr_hash->start_address,
+			pfr_manifest->pfr_hash->length, generation, hash_out);
+	pfr_region_hash_insert(device_id, type, nested_address, nested_length, generation,
+			nested_hash);
+
+	return Success;
+}
+#endif
+
+#if defined(CONFIG_PFR_REGION_CHUNK_DIGEST)
+/**
+ * RoT private chunk digest table.
+ *
+ * When a region is hashed in full, a SHA-256 digest of every CONFIG_PFR_REGION_CHUNK_SIZE chunk
+ * is taken from the same flash reads and kept with the region digest. The entry is trusted once
+ * the caller has matched the region digest against its manifest. Later verifications of the
+ * region compare it chunk by chunk and report every chunk that differs, an intact region gets
+ * the trusted region digest back.
+ *
+ * The table mutex is never held across flash reads. An entry being recorded or compared is
+ * pinned by refs, so its chunk digests are neither reallocated nor rewritten meanwhile.
+ */
+struct pfr_region_chunk_entry {
+	bool valid;
+	bool trusted;
+	uint8_t refs;
+	uint8_t device_id;
+	uint32_t type;
+	uint32_t address;
+	uint32_t length;
+	uint32_t first;
+	uint32_t capacity;
+	uint8_t digest[SHA384_HASH_LENGTH];
+};
+
+static struct pfr_region_chunk_entry pfr_region_chunk_table[CONFIG_PFR_REGION_CHUNK_REGIONS];
+static uint8_t pfr_region_chunk_digests[CONFIG_PFR_REGION_CHUNK_DIGESTS][SHA256_HASH_LENGTH];
+static uint32_t pfr_region_chunk_used;
+static K_MUTEX_DEFINE(pfr_region_chunk_mutex);
+
+static uint32_t pfr_region_chunk_count(uint32_t length)
+{
+	return DIV_ROUND_UP(length, CONFIG_PFR_REGION_CHUNK_SIZE);
+}
+
+static struct pfr_region_chunk_entry *pfr_region_chunk_find(uint8_t device_id, uint32_t type,
+		uint32_t address, uint32_t length)
+{
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(pfr_region_chunk_table); i++) {
+		struct pfr_region_chunk_entry *entry = &pfr_region_chunk_table[i];
+
+		if (entry->valid && entry->device_id == device_id && entry->type == type &&
+		    entry->address == address && entry->length == length)
+			return entry;
+	}
+
+	return NULL;
+}
+
+static bool pfr_region_chunk_pinned(void)
+{
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(pfr_region_chunk_table); i++) {
+		if (pfr_region_chunk_table[i].refs)
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * Take an entry for the region and pin it for recording, the table is started over when it runs
+ * out of room. Returns NULL if the region does not fit or the room is pinned by another thread.
+ */
+static struct pfr_region_chunk_entry *pfr_region_chunk_alloc(uint8_t device_id, uint32_t type,
+		uint32_t address, uint32_t length)
+{
+	struct pfr_region_chunk_entry *entry;
+	uint32_t count = pfr_region_chunk_count(length);
+	size_t i;
+
+	if (count > CONFIG_PFR_REGION_CHUNK_DIGESTS)
+		return NULL;
+
+	entry = pfr_region_chunk_find(device_id, type, address, length);
+	if (entry && entry->refs)
+		return NULL;
+
+	if (entry == NULL || entry->capacity < count) {
+		if (entry)
+			entry->valid = false;
+		entry = NULL;
+		for (i = 0; i < ARRAY_SIZE(pfr_region_chunk_table); i++) {
+			if (!pfr_region_chunk_table[i].valid) {
+				entry = &pfr_region_chunk_table[i];
+				break;
+			}
+		}
+
+		if (entry == NULL || CONFIG_PFR_REGION_CHUNK_DIGESTS - pfr_region_chunk_used < count) {
+			if (pfr_region_chunk_pinned())
+				return NULL;
+
+			LOG_DBG("Chunk digest table full, starting over");
+			memset(pfr_region_chunk_table, 0, sizeof(pfr_region_chunk_table));
+			pfr_region_chunk_used = 0;
+			entry = &pfr_region_chunk_table[0];
+		}
+
+		entry->first = pfr_region_chunk_used;
+		entry->capacity = count;
+		pfr_region_chunk_used += count;
+	}
+
+	entry->valid = true;
+	entry->trusted = false;
+	entry->refs = 1;
+	entry->device_id = device_id;
+	entry->type = type;
+	entry->address = address;
+	entry->length = length;
+
+	return entry;
+}
+
+/*
+ * Compare the chunks of a pinned entry with flash, without the table mutex. Stops at the first
+ * chunk which differs unless bad_chunks is given, then every chunk is checked and the ones which
+ * differ are set in bad_chunks.
+ *
+ * Returns 0 if every chunk matches, -EBADMSG if a chunk differs or an error code.
+ */
+static int pfr_region_chunk_compare(const struct pfr_region_chunk_entry *entry,
+		uint32_t *bad_chunks)
+{
+	uint8_t digest[SHA256_HASH_LENGTH];
+	uint32_t count = pfr_region_chunk_count(entry->length);
+	uint32_t offset;
+	uint32_t i;
+	int status = 0;
+	int ret;
+
+	if (bad_chunks)
+		memset(bad_chunks, 0, PFR_REGION_CHUNK_MAP_WORDS * sizeof(uint32_t));
+	for (i = 0; i < count; i++) {
+		offset = i * CONFIG_PFR_REGION_CHUNK_SIZE;
+		ret = pfr_spi_hash_region(entry->device_id, entry->address + offset,
+				MIN(entry->length - offset, CONFIG_PFR_REGION_CHUNK_SIZE),
+				HASH_SHA256, digest, sizeof(digest));
+		if (ret)
+			return ret;
+
+		if (memcmp(digest, pfr_region_chunk_digests[entry->first + i], sizeof(digest))) {
+			LOG_ERR("Region dev(%d) address(%x) changed at chunk %d, address(%x)",
+					entry->device_id, entry->address, i, entry->address + offset);
+			if (bad_chunks == NULL)
+				return -EBADMSG;
+			bad_chunks[i / 32] |= BIT(i % 32);
+			status = -EBADMSG;
+		}
+	}
+
+	return status;
+}
+
+static void pfr_region_chunk_unpin(struct pfr_region_chunk_entry *entry, bool valid)
+{
+	k_mutex_lock(&pfr_region_chunk_mutex, K_FOREVER);
+	entry->refs--;
+	if (!valid)
+		entry->valid = false;
+	k_mutex_unlock(&pfr_region_chunk_mutex);
+}
+
+/**
+ * Calculate the digest of the manifest hash region like get_hash, using the chunk digest table.
+ * The trusted chunk digests are only used when they were recorded for the expected digest, a
+ * region updated to a new manifest is recorded again.
+ *
+ * @param bad_chunks NULL to stop at the first chunk that differs, or a bitmap of
+ * PFR_REGION_CHUNK_MAP_WORDS words for callers that repair chunks. Every chunk is then checked and
+ * bit n is set if chunk n of the region differs from its trusted digest. Only filled when
+ * -EBADMSG is returned.
+ *
+ * @return Success if the digest was calculated, -EBADMSG if the region no longer matches its
+ * trusted chunk digests or an error code.
+ */
+int get_hash_chunked(struct manifest *manifest, struct hash_engine *hash_engine,
+		const uint8_t *expected, uint8_t *hash_out, size_t hash_length,
+		uint32_t *bad_chunks)
+{
+	struct pfr_manifest *pfr_manifest = (struct pfr_manifest *)manifest;
+	struct pfr_region_chunk_entry *entry;
+	uint32_t generation;
+	uint32_t address;
+	uint32_t length;
+	uint32_t type;
+	uint8_t device_id;
+	size_t digest_length;
+	int status;
+
+	if (pfr_manifest == NULL || hash_engine == NULL || expected == NULL || hash_out == NULL)
+		return Failure;
+
+	device_id = pfr_manifest->flash->state->device_id[0];
+	type = pfr_manifest->pfr_hash->type;
+	address = pfr_manifest->pfr_hash->start_address;
+	length = pfr_manifest->pfr_hash->length;
+	digest_length = pfr_region_hash_digest_length(type);
+	if (digest_length == 0 || digest_length > hash_length || length == 0)
+		return get_hash(manifest, hash_engine, hash_out, hash_length);
+
+	// An unchanged device needs neither pass
+	if (pfr_region_hash_lookup(device_id, type, address, length, hash_out))
+		return Success;
+
+	generation = flash_write_generation_get(device_id);
+	k_mutex_lock(&pfr_region_chunk_mutex, K_FOREVER);
+	entry = pfr_region_chunk_find(device_id, type, address, length);
+	if (entry && entry->trusted && !memcmp(entry->digest, expected, digest_length)) {
+		entry->refs++;
+		k_mutex_unlock(&pfr_region_chunk_mutex);
+
+		status = pfr_region_chunk_compare(entry, bad_chunks);
+		if (status == 0)
+			memcpy(hash_out, entry->digest, digest_length);
+		pfr_region_chunk_unpin(entry, true);
+		if (status == -ENOMEM)
+			return get_hash(manifest, hash_engine, hash_out, hash_length);
+	} else {
+		entry = pfr_region_chunk_alloc(device_id, type, address, length);
+		k_mutex_unlock(&pfr_region_chunk_mutex);
+		if (entry == NULL)
+			return get_hash(manifest, hash_engine, hash_out, hash_length);
+
+		status = pfr_spi_hash_region_chunked(device_id, address, length,
+				(type == HASH_TYPE_SHA256) ? HASH_SHA256 : HASH_SHA384,
+				hash_out, digest_length, CONFIG_PFR_REGION_CHUNK_SIZE, HASH_SHA256,
+				pfr_region_chunk_digests[entry->first], SHA256_HASH_LENGTH);
+		if (status == 0)
+			memcpy(entry->digest, hash_out, digest_length);
+		pfr_region_chunk_unpin(entry, status == 0);
+		// Out of DMA buffers or hash sessions, fall back to the plain path
+		if (status == -ENOMEM)
+			return get_hash(manifest, hash_engine, hash_out, hash_length);
+	}
+
+	if (status == 0)
+		pfr_region_hash_insert(device_id, type, address, length, generation, hash_out);
+
+	return status;
+}
+
+/**
+ * Trust the chunk digests recorded for a region once its digest matched the manifest.
+ */
+void pfr_region_chunk_trust(uint8_t device_id, uint32_t type, uint32_t address, uint32_t length,
+		const uint8_t *digest)
+{
+	struct pfr_region_chunk_entry *entry;
+
+	k_mutex_lock(&pfr_region_chunk_mutex, K_FOREVER);
+	entry = pfr_region_chunk_find(device_id, type, address, length);
+	if (entry && !entry->refs &&
+	    !memcmp(entry->digest, digest, pfr_region_hash_digest_length(type)))
+		entry->trusted = true;
+	k_mutex_unlock(&pfr_region_chunk_mutex);
+}
+#endif
+
+#if defined(CONFIG_PFR_ECDSA_KEY_CACHE)
+/**
+ * Curve groups and decoded public keys are kept across verifications. The same root and CSK
+ * keys are checked over and over during block1, PFM and capsule verification, and keeping the
+ * group also keeps the comb table mbedtls builds for the base point on first use.
+ */
+struct ecdsa_key_cache_entry {
+	bool valid;
+	size_t length;
+	uint32_t last_used;
+	uint8_t x[SHA384_HASH_LENGTH];
+	uint8_t y[SHA384_HASH_LENGTH];
+	mbedtls_ecp_point q;
+};
+
+static struct ecdsa_key_cache_entry ecdsa_key_cache[CONFIG_PFR_ECDSA_KEY_CACHE_SIZE];
+static mbedtls_ecp_group ecdsa_group_cache[2];	// secp256r1, secp384r1
+static bool ecdsa_group_loaded[2];
+static uint32_t ecdsa_key_cache_clock;
+static K_MUTEX_DEFINE(ecdsa_key_cache_mutex);
+
+static mbedtls_ecp_group *ecdsa_cache_get_group(size_t length)
+{
+	mbedtls_ecp_group_id id;
+	int index;
+
+	if (length == SHA256_HASH_LENGTH) {
+		index = 0;
+		id = MBEDTLS_ECP_DP_SECP256R1;
+	} else if (length == SHA384_HASH_LENGTH) {
+		index = 1;
+		id = MBEDTLS_ECP_DP_SECP384R1;
+	} else {
+		LOG_ERR("Unsupported ECDSA curve length, %d", length);
+		return NULL;
+	}
+
+	if (!ecdsa_group_loaded[index]) {
+		mbedtls_ecp_group_init(&ecdsa_group_cache[index]);
+		if (mbedtls_ecp_group_load(&ecdsa_group_cache[index], id)) {
+			mbedtls_ecp_group_free(&ecdsa_group_cache[index]);
+			return NULL;
+		}
+		ecdsa_group_loaded[index] = true;
+	}
+
+	return &ecdsa_group_cache[index];
+}
+
+static mbedtls_ecp_point *ecdsa_cache_get_key(struct pfr_pubkey *pubkey, size_t length)
+{
+	struct ecdsa_key_cache_entry *entry = NULL;
+	size_t i;
+
+	ecdsa_key_cache_clock++;
+	for (i = 0; i < ARRAY_SIZE(ecdsa_key_cache); i++) {
+		if (ecdsa_key_cache[i].valid && ecdsa_key_cache[i].length == length &&
+		    !memcmp(ecdsa_key_cache[i].x, pubkey->x, length) &&
+		    !memcmp(ecdsa_key_cache[i].y, pubkey->y, length)) {
+			ecdsa_key_cache[i].last_used = ecdsa_key_cache_clock;
+			return &ecdsa_key_cache[i].q;
+		}
+	}
+
+	// Miss, take a free entry or evict the least recently used one
+	for (i = 0; i < ARRAY_SIZE(ecdsa_key_cache); i++) {
+		if (!ecdsa_key_cache[i].valid) {
+			entry = &ecdsa_key_cache[i];
+			break;
+		}
+		if (entry == NULL || ecdsa_key_cache[i].last_used < entry->last_used)
+			entry = &ecdsa_key_cache[i];
+	}
+
+	if (entry->valid)
+		mbedtls_ecp_point_free(&entry->q);
+
+	entry->valid = false;
+	mbedtls_ecp_point_init(&entry->q);
+	if (mbedtls_mpi_read_binary(&entry->q.MBEDTLS_PRIVATE(X), pubkey->x, length) ||
+	    mbedtls_mpi_read_binary(&entry->q.MBEDTLS_PRIVATE(Y), pubkey->y, length) ||
+	    mbedtls_mpi_lset(&entry->q.MBEDTLS_PRIVATE(Z), 1)) {
+		mbedtls_ecp_point_free(&entry->q);
+		return NULL;
+	}
+
+	memcpy(entry->x, pubkey->x, length);
+	memcpy(entry->y, pubkey->y, length);
+	entry->length = length;
+	entry->last_used = ecdsa_key_cache_clock;
+	entry->valid = true;
+
+	return &entry->q;
+}
+
+static int mbedtls_ecdsa_verify_middlelayer(struct pfr_pubkey *pubkey,
+					    const uint8_t *digest, size_t length, uint8_t *signature_r,
+					    uint8_t *signature_s)
+{
+	mbedtls_ecp_group *grp;
+	mbedtls_ecp_point *q;
+	mbedtls_mpi r;
+	mbedtls_mpi s;
+	int ret;
+
+	mbedtls_mpi_init(&r);
+	mbedtls_mpi_init(&s);
+	mbedtls_mpi_read_binary(&r, signature_r, length);
+	mbedtls_mpi_read_binary(&s, signature_s, length);
+
+	// The group's comb table is filled in lazily, so verifications are serialized
+	k_mutex_lock(&ecdsa_key_cache_mutex, K_FOREVER);
+	grp = ecdsa_cache_get_group(length);
+	q = grp ? ecdsa_cache_get_key(pubkey, length) : NULL;
+	if (q)
+		ret = mbedtls_ecdsa_verify(grp, digest, length, q, &r, &s);
+	else
+		ret = MBEDTLS_ERR_ECP_BAD_INPUT_DATA;
+	k_mutex_unlock(&ecdsa_key_cache_mutex);
+
+	mbedtls_mpi_free(&r);
+	mbedtls_mpi_free(&s);
+	return ret;
+}
+#else
 static int mbedtls_ecdsa_verify_middlelayer(struct pfr_pubkey *pubkey,
 					    const uint8_t *digest, size_t length, uint8_t *signature_r,
 					    uint8_t *signature_s)
@@ -226,6 +1365,96 @@ static int mbedtls_ecdsa_verify_middlelayer(struct pfr_pubkey *pubkey,
 	return ret;
 
 }
+#endif
+
+#if defined(CONFIG_PFR_SIG_CACHE)
+/**
+ * Successful signature verifications are remembered for the rest of the boot cycle. An entry is
+ * the SHA-256 of the digest, the public key and the signature, so a blob whose content changed
+ * on flash produces a different digest and never hits a stale entry.
+ */
+struct pfr_sig_cache_entry {
+	bool valid;
+	uint8_t fingerprint[SHA256_HASH_LENGTH];
+};
+
+static struct pfr_sig_cache_entry pfr_sig_cache[CONFIG_PFR_SIG_CACHE_SIZE];
+static size_t pfr_sig_cache_next;
+static K_MUTEX_DEFINE(pfr_sig_cache_mutex);
+
+static int pfr_sig_cache_fingerprint(const uint8_t *digest, size_t digest_length,
+		const uint8_t *key, size_t key_length, const uint8_t *signature, size_t sig_length,
+		uint8_t *fingerprint)
+{
+	struct hash_session *session;
+	int status;
+
+	status = hash_engine_session_start(HASH_SHA256, &session);
+	if (status)
+		return status;
+
+	status = hash_engine_session_update(session, digest, digest_length);
+	if (!status)
+		status = hash_engine_session_update(session, key, key_length);
+	if (!status)
+		status = hash_engine_session_update(session, signature, sig_length);
+	if (status) {
+		hash_engine_session_cancel(session);
+		return status;
+	}
+
+	return hash_engine_session_finish(session, fingerprint, SHA256_HASH_LENGTH);
+}
+
+/**
+ * Check whether a signature over a digest was already verified with the same key.
+ *
+ * @return true if the verification succeeded earlier in this boot cycle.
+ */
+bool pfr_sig_cache_lookup(const uint8_t *digest, size_t digest_length, const uint8_t *key,
+		size_t key_length, const uint8_t *signature, size_t sig_length)
+{
+	uint8_t fingerprint[SHA256_HASH_LENGTH];
+	bool found = false;
+	size_t i;
+
+	if (pfr_sig_cache_fingerprint(digest, digest_length, key, key_length, signature,
+				sig_length, fingerprint))
+		return false;
+
+	k_mutex_lock(&pfr_sig_cache_mutex, K_FOREVER);
+	for (i = 0; i < ARRAY_SIZE(pfr_sig_cache); i++) {
+		if (pfr_sig_cache[i].valid &&
+		    !memcmp(pfr_sig_cache[i].fingerprint, fingerprint, sizeof(fingerprint))) {
+			found = true;
+			break;
+		}
+	}
+	k_mutex_unlock(&pfr_sig_cache_mutex);
+
+	return found;
+}
+
+/**
+ * Record a successful signature verification. The oldest entry is replaced when the cache is
+ * full.
+ */
+void pfr_sig_cache_insert(const uint8_t *digest, size_t digest_length, const uint8_t *key,
+		size_t key_length, const uint8_t *signature, size_t sig_length)
+{
+	uint8_t fingerprint[SHA256_HASH_LENGTH];
+
+	if (pfr_sig_cache_fingerprint(digest, digest_length, key, key_length, signature,
+				sig_length, fingerprint))
+		return;
+
+	k_mutex_lock(&pfr_sig_cache_mutex, K_FOREVER);
+	memcpy(pfr_sig_cache[pfr_sig_cache_next].fingerprint, fingerprint, sizeof(fingerprint));
+	pfr_sig_cache[pfr_sig_cache_next].valid = true;
+	pfr_sig_cache_next = (pfr_sig_cache_next + 1) % ARRAY_SIZE(pfr_sig_cache);
+	k_mutex_unlock(&pfr_sig_cache_mutex);
+}
+#endif
 
 /**
  * Verify that a calculated digest matches a signature.
@@ -243,10 +1472,28 @@ int verify_signature(struct signature_verification *verification, const uint8_t
 {
 	struct pfr_manifest *manifest = (struct pfr_manifest *)verification;
 	int status = Success;
+#if defined(CONFIG_PFR_SIG_CACHE)
+	struct pfr_pubkey *pubkey = manifest->verification->pubkey;
+	uint8_t key[2 * SHA384_HASH_LENGTH];
+	uint8_t sig[2 * SHA384_HASH_LENGTH];
+#endif
 
 	ARG_UNUSED(signature);
 	ARG_UNUSED(sig_length);
 
+#if defined(CONFIG_PFR_SIG_CACHE)
+	if (length == SHA256_HASH_LENGTH || length == SHA384_HASH_LENGTH) {
+		memcpy(key, pubkey->x, length);
+		memcpy(key + length, pubkey->y, length);
+		memcpy(sig, pubkey->signature_r, length);
+		memcpy(sig + length, pubkey->signature_s, length);
+		if (pfr_sig_cache_lookup(digest, length, key, 2 * length, sig, 2 * length)) {
+			LOG_DBG("ECDSA signature verified earlier in this boot");
+			return Success;
+		}
+	}
+#endif
+
 	if (length == SHA256_HASH_LENGTH) {
 		LOG_DBG("MBEDTLS ECDSA Start");
 		status = mbedtls_ecdsa_verify_middlelayer(manifest->verification->pubkey,
@@ -267,6 +1514,11 @@ int verify_signature(struct signature_verification *verification, const uint8_t
 	} else
 		LOG_ERR("Unsupported digest length, %d", length);
 
+#if defined(CONFIG_PFR_SIG_CACHE)
+	if (status == Success && (length == SHA256_HASH_LENGTH || length == SHA384_HASH_LENGTH))
+		pfr_sig_cache_insert(digest, length, key, 2 * length, sig, 2 * length);
+#endif
+
 	return status;
 }
 
@@ -7,6 +7,10 @@
 #pragma once
 
 #include "pfr_common.h"
+#include "crypto/hash_aspeed.h"
+
+#define PFR_ERASE_CAP_32K	BIT(0)
+#define PFR_ERASE_CAP_64K	BIT(1)
 
 int pfr_spi_read(uint8_t device_id, uint32_t address,
 		 uint32_t data_length, uint8_t *data);
@@ -20,21 +24,72 @@ int pfr_spi_erase_4k(uint8_t device_id, uint32_t address);
 
 int pfr_spi_erase_block(uint8_t device_id, uint32_t address);
 
+uint8_t pfr_spi_erase_plan_next(uint32_t addr, uint32_t end_addr, uint8_t erase_caps,
+		uint32_t *size);
+
 int pfr_spi_erase_region(uint8_t device_id,
 		bool support_block_erase, uint32_t start_addr, uint32_t nbytes);
 
 int pfr_spi_region_read_write_between_spi(uint8_t src_dev, uint32_t src_addr,
 		uint8_t dest_dev, uint32_t dest_addr, size_t length);
 
+#if defined(CONFIG_PFR_SPI_DIFF_COPY)
+int pfr_spi_region_diff_copy(uint8_t src_dev, uint32_t src_addr,
+		uint8_t dest_dev, uint32_t dest_addr, size_t length, uint32_t *written_sectors);
+#endif
+
 uint32_t pfr_spi_get_device_size(uint8_t device_id);
 
 int pfr_spi_get_block_size(uint8_t device_id);
 
+#if defined(CONFIG_PFR_SPI_HASH_STREAM)
+struct pfr_spi_extent {
+	uint8_t device_id;
+	uint32_t address;
+	uint32_t length;
+};
+
+int pfr_spi_hash_extents(const struct pfr_spi_extent *extents, size_t count,
+		enum hash_algo algo, uint8_t *hash_out, size_t hash_length);
+int pfr_spi_hash_region(uint8_t device_id, uint32_t address, uint32_t length,
+		enum hash_algo algo, uint8_t *hash_out, size_t hash_length);
+int pfr_spi_hash_region_nested(uint8_t device_id, uint32_t address, uint32_t length,
+		uint32_t nested_address, uint32_t nested_length, enum hash_algo algo,
+		uint8_t *hash_out, uint8_t *nested_hash_out, size_t hash_length);
+int pfr_spi_hash_region_chunked(uint8_t device_id, uint32_t address, uint32_t length,
+		enum hash_algo algo, uint8_t *hash_out, size_t hash_length, uint32_t chunk_size,
+		enum hash_algo chunk_algo, uint8_t *chunk_hash_out, size_t chunk_hash_length);
+#endif
+
 int get_hash(struct manifest *manifest, struct hash_engine *hash_engine, uint8_t *hash_out,
 	     size_t hash_length);
 
+#if defined(CONFIG_PFR_NESTED_MANIFEST_HASH)
+int get_hash_nested(struct manifest *manifest, struct hash_engine *hash_engine,
+		uint32_t nested_address, uint32_t nested_length, uint8_t *hash_out,
+		size_t hash_length);
+#endif
+
+#if defined(CONFIG_PFR_REGION_CHUNK_DIGEST)
+/* Words of a bitmap with one bit per chunk of the largest region in the chunk digest table */
+#define PFR_REGION_CHUNK_MAP_WORDS	DIV_ROUND_UP(CONFIG_PFR_REGION_CHUNK_DIGESTS, 32)
+
+int get_hash_chunked(struct manifest *manifest, struct hash_engine *hash_engine,
+		const uint8_t *expected, uint8_t *hash_out, size_t hash_length,
+		uint32_t *bad_chunks);
+void pfr_region_chunk_trust(uint8_t device_id, uint32_t type, uint32_t address, uint32_t length,
+		const uint8_t *digest);
+#endif
+
 int verify_signature(struct signature_verification *verification, const uint8_t *digest,
 		     size_t length, const uint8_t *signature, size_t sig_length);
 
+#if defined(CONFIG_PFR_SIG_CACHE)
+bool pfr_sig_cache_lookup(const uint8_t *digest, size_t digest_length, const uint8_t *key,
+		size_t key_length, const uint8_t *signature, size_t sig_length);
+void pfr_sig_cache_insert(const uint8_t *digest, size_t digest_length, const uint8_t *key,
+		size_t key_length, const uint8_t *signature, size_t sig_length);
+#endif
+
 void pfr_cpld_update_reboot(void);
 
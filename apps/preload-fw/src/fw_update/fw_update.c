@@ -133,6 +133,47 @@ uint32_t cal_checksum(const struct device *dev, uint32_t addr, uint32_t size)
 	return crc;
 }
 
+static bool is_flash_area_blank(const struct flash_area *fa, uint32_t off, uint32_t size)
+{
+	uint32_t *word = (uint32_t *)flash_buf;
+	uint32_t read_size;
+	uint32_t i;
+
+	while (size) {
+		read_size = (size >= PAGE_SIZE) ? PAGE_SIZE : size;
+		if (flash_area_read(fa, off, flash_buf, read_size))
+			return false;
+
+		for (i = 0; i < read_size / sizeof(uint32_t); i++) {
+			if (word[i] != 0xffffffff)
+				return false;
+		}
+
+		off += read_size;
+		size -= read_size;
+	}
+
+	return true;
+}
+
+/* Erase the flash area one erase block at a time, skipping blocks that are already blank. */
+static int erase_flash_area(const struct flash_area *fa)
+{
+	uint32_t off;
+	uint32_t size;
+
+	for (off = 0; off < fa->fa_size; off += size) {
+		size = MIN(ERASE_BLOCK_SIZE, fa->fa_size - off);
+		if (is_flash_area_blank(fa, off, size))
+			continue;
+
+		if (flash_area_erase(fa, off, size))
+			return -1;
+	}
+
+	return 0;
+}
+
 const struct device *get_flash_dev(uint8_t flash_id)
 {
 	const struct device *flash_dev;
@@ -194,7 +235,11 @@ int rot_fw_update(void)
 		return -1;
 	}
 
-	flash_area_erase(fa, 0, fa->fa_size);
+	if (erase_flash_area(fa)) {
+		LOG_ERR("Failed to erase active partition");
+		goto fwu_error;
+	}
+
 	uint32_t read_addr = rot_fw_staging_addr;
 	uint32_t write_addr = fa->fa_off;
 	uint32_t remaining = rot_fw_size;
@@ -10,6 +10,7 @@
 #include "sw_mailbox/sw_mailbox.h"
 
 #define PAGE_SIZE 4096
+#define ERASE_BLOCK_SIZE 0x10000
 
 enum {
 	BMC_FLASH_ID = 0,
@@ -0,0 +1,759 @@
+/*
+ * Copyright (c) 2023 ASPEED Technology Inc.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/** @file
+ * SHA-256/384/512 digest Wrapper Implementation on the ASPEED hash engine.
+ *
+ * Digests are computed by the hash engine and fall back to mbedtls when the engine is busy,
+ * not available or the data does not fit in the staging buffer, see sha_hw_context_t.
+ **/
+
+#include <zephyr.h>
+#include <device.h>
+#include <crypto/hash.h>
+#include "hash/sha_aspeed.h"
+#include "hash_engine_lock.h"
+
+size_t sha_hw_get_blocksize(mbedtls_md_type_t md_type)
+{
+    switch (md_type) {
+    case MBEDTLS_MD_SHA256:
+        return 64;
+    case MBEDTLS_MD_SHA384:
+    case MBEDTLS_MD_SHA512:
+        return 128;
+    default:
+        return 0;
+    }
+}
+
+size_t sha_hw_get_digest_size(mbedtls_md_type_t md_type)
+{
+    switch (md_type) {
+    case MBEDTLS_MD_SHA256:
+        return LIBSPDM_SHA256_DIGEST_SIZE;
+    case MBEDTLS_MD_SHA384:
+        return LIBSPDM_SHA384_DIGEST_SIZE;
+    case MBEDTLS_MD_SHA512:
+        return LIBSPDM_SHA512_DIGEST_SIZE;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * Computes a digest in one pass on the hash engine.
+ *
+ * @retval true   The digest was computed by the hash engine.
+ * @retval false  The hash engine is busy or not available, the caller must use software.
+ **/
+static bool sha_hw_engine_all(mbedtls_md_type_t md_type, const void *data,
+                              size_t data_size, uint8_t *hash_value)
+{
+    const struct device *dev = device_get_binding(CONFIG_CRYPTO_ASPEED_HASH_DRV_NAME);
+    struct hash_ctx ctx;
+    struct hash_pkt pkt;
+    enum hash_algo algo;
+    int ret;
+
+    switch (md_type) {
+    case MBEDTLS_MD_SHA256:
+        algo = HASH_SHA256;
+        break;
+    case MBEDTLS_MD_SHA384:
+        algo = HASH_SHA384;
+        break;
+    case MBEDTLS_MD_SHA512:
+        algo = HASH_SHA512;
+        break;
+    default:
+        return false;
+    }
+
+    if (dev == NULL) {
+        return false;
+    }
+
+    libspdm_zero_mem(&ctx, sizeof(ctx));
+    libspdm_zero_mem(&pkt, sizeof(pkt));
+
+    /* The engine is shared with hrot_hal, see hash_engine_lock.h */
+    if (!hash_engine_hw_try_acquire()) {
+        return false;
+    }
+
+    ret = hash_begin_session(dev, &ctx, algo);
+    if (ret == 0) {
+        if (data_size != 0) {
+            pkt.in_buf = (uint8_t *)data;
+            pkt.in_len = data_size;
+            ret = hash_update(&ctx, &pkt);
+        }
+        if (ret == 0) {
+            pkt.out_buf = hash_value;
+            pkt.out_buf_max = sha_hw_get_digest_size(md_type);
+            ret = hash_final(&ctx, &pkt);
+        }
+        hash_free_session(dev, &ctx);
+    }
+    hash_engine_hw_release();
+
+    return ret == 0;
+}
+
+static bool sha_hw_sw_all(mbedtls_md_type_t md_type, const void *data,
+                          size_t data_size, uint8_t *hash_value)
+{
+    int ret;
+
+    switch (md_type) {
+    case MBEDTLS_MD_SHA256:
+        ret = mbedtls_sha256(data, data_size, hash_value, false);
+        break;
+    case MBEDTLS_MD_SHA384:
+        ret = mbedtls_sha512(data, data_size, hash_value, true);
+        break;
+    case MBEDTLS_MD_SHA512:
+        ret = mbedtls_sha512(data, data_size, hash_value, false);
+        break;
+    default:
+        return false;
+    }
+
+    return ret == 0;
+}
+
+static bool sha_hw_sw_starts(sha_hw_context_t *ctx)
+{
+    if (ctx->md_type == MBEDTLS_MD_SHA256) {
+        mbedtls_sha256_init(&ctx->sw_ctx.sha256);
+        return mbedtls_sha256_starts(&ctx->sw_ctx.sha256, false) == 0;
+    }
+
+    mbedtls_sha512_init(&ctx->sw_ctx.sha512);
+    return mbedtls_sha512_starts(&ctx->sw_ctx.sha512,
+                                 ctx->md_type == MBEDTLS_MD_SHA384) == 0;
+}
+
+static bool sha_hw_sw_update(sha_hw_context_t *ctx, const void *data,
+                             size_t data_size)
+{
+    if (ctx->md_type == MBEDTLS_MD_SHA256) {
+        return mbedtls_sha256_update(&ctx->sw_ctx.sha256, data, data_size) == 0;
+    }
+
+    return mbedtls_sha512_update(&ctx->sw_ctx.sha512, data, data_size) == 0;
+}
+
+static bool sha_hw_sw_finish(sha_hw_context_t *ctx, uint8_t *hash_value)
+{
+    if (ctx->md_type == MBEDTLS_MD_SHA256) {
+        return mbedtls_sha256_finish(&ctx->sw_ctx.sha256, hash_value) == 0;
+    }
+
+    return mbedtls_sha512_finish(&ctx->sw_ctx.sha512, hash_value) == 0;
+}
+
+static void sha_hw_sw_free(sha_hw_context_t *ctx)
+{
+    if (ctx->md_type == MBEDTLS_MD_SHA256) {
+        mbedtls_sha256_free(&ctx->sw_ctx.sha256);
+    } else {
+        mbedtls_sha512_free(&ctx->sw_ctx.sha512);
+    }
+}
+
+/**
+ * Moves the staged data into the software context. Used when the staging buffer would
+ * overflow or cannot be grown.
+ **/
+static bool sha_hw_fold(sha_hw_context_t *ctx)
+{
+    bool ret;
+
+    ret = sha_hw_sw_starts(ctx);
+    if (ret && ctx->stage_size != 0) {
+        ret = sha_hw_sw_update(ctx, ctx->stage, ctx->stage_size);
+    }
+
+    if (ctx->stage != NULL) {
+        libspdm_zero_mem(ctx->stage, ctx->stage_capacity);
+        free_pool(ctx->stage);
+    }
+    ctx->stage = NULL;
+    ctx->stage_size = 0;
+    ctx->stage_capacity = 0;
+    ctx->sw = true;
+
+    return ret;
+}
+
+static bool sha_hw_stage_reserve(sha_hw_context_t *ctx, size_t size)
+{
+    uint8_t *stage;
+    size_t capacity;
+
+    if (size <= ctx->stage_capacity) {
+        return true;
+    }
+
+    capacity = MAX(ctx->stage_capacity * 2, 256);
+    capacity = MAX(capacity, size);
+    capacity = MIN(capacity, CONFIG_DMTF_LIBSPDM_HW_HASH_STAGE_MAX);
+
+    stage = allocate_pool(capacity);
+    if (stage == NULL) {
+        return false;
+    }
+
+    if (ctx->stage != NULL) {
+        libspdm_copy_mem(stage, capacity, ctx->stage, ctx->stage_size);
+        libspdm_zero_mem(ctx->stage, ctx->stage_capacity);
+        free_pool(ctx->stage);
+    }
+    ctx->stage = stage;
+    ctx->stage_capacity = capacity;
+
+    return true;
+}
+
+bool sha_hw_init(sha_hw_context_t *ctx, mbedtls_md_type_t md_type)
+{
+    if (ctx == NULL || sha_hw_get_digest_size(md_type) == 0) {
+        return false;
+    }
+
+    libspdm_zero_mem(ctx, sizeof(*ctx));
+    ctx->md_type = md_type;
+
+    return true;
+}
+
+void sha_hw_release(sha_hw_context_t *ctx)
+{
+    if (ctx == NULL) {
+        return;
+    }
+
+    if (ctx->stage != NULL) {
+        libspdm_zero_mem(ctx->stage, ctx->stage_capacity);
+        free_pool(ctx->stage);
+    }
+    if (ctx->sw) {
+        sha_hw_sw_free(ctx);
+    }
+    libspdm_zero_mem(ctx, sizeof(*ctx));
+}
+
+bool sha_hw_duplicate(const sha_hw_context_t *ctx, sha_hw_context_t *new_ctx)
+{
+    if (ctx == NULL || new_ctx == NULL) {
+        return false;
+    }
+
+    sha_hw_release(new_ctx);
+    new_ctx->md_type = ctx->md_type;
+    new_ctx->sw = ctx->sw;
+
+    if (ctx->sw) {
+        if (ctx->md_type == MBEDTLS_MD_SHA256) {
+            mbedtls_sha256_init(&new_ctx->sw_ctx.sha256);
+            mbedtls_sha256_clone(&new_ctx->sw_ctx.sha256, &ctx->sw_ctx.sha256);
+        } else {
+            mbedtls_sha512_init(&new_ctx->sw_ctx.sha512);
+            mbedtls_sha512_clone(&new_ctx->sw_ctx.sha512, &ctx->sw_ctx.sha512);
+        }
+        return true;
+    }
+
+    if (ctx->stage_size == 0) {
+        return true;
+    }
+
+    if (!sha_hw_stage_reserve(new_ctx, ctx->stage_size)) {
+        return false;
+    }
+    libspdm_copy_mem(new_ctx->stage, new_ctx->stage_capacity,
+                     ctx->stage, ctx->stage_size);
+    new_ctx->stage_size = ctx->stage_size;
+
+    return true;
+}
+
+bool sha_hw_update(sha_hw_context_t *ctx, const void *data, size_t data_size)
+{
+    if (ctx == NULL) {
+        return false;
+    }
+
+    if (data == NULL && data_size != 0) {
+        return false;
+    }
+    if (data_size > INT_MAX) {
+        return false;
+    }
+    if (data_size == 0) {
+        return true;
+    }
+
+    if (!ctx->sw) {
+        if (data_size <= CONFIG_DMTF_LIBSPDM_HW_HASH_STAGE_MAX - ctx->stage_size &&
+            sha_hw_stage_reserve(ctx, ctx->stage_size + data_size)) {
+            libspdm_copy_mem(ctx->stage + ctx->stage_size,
+                             ctx->stage_capacity - ctx->stage_size,
+                             data, data_size);
+            ctx->stage_size += data_size;
+            return true;
+        }
+
+        if (!sha_hw_fold(ctx)) {
+            return false;
+        }
+    }
+
+    return sha_hw_sw_update(ctx, data, data_size);
+}
+
+bool sha_hw_final(sha_hw_context_t *ctx, uint8_t *hash_value)
+{
+    bool ret;
+
+    if (ctx == NULL || hash_value == NULL) {
+        return false;
+    }
+
+    if (ctx->sw) {
+        ret = sha_hw_sw_finish(ctx, hash_value);
+    } else {
+        ret = sha_hw_all(ctx->md_type, ctx->stage, ctx->stage_size, hash_value);
+    }
+    sha_hw_release(ctx);
+
+    return ret;
+}
+
+bool sha_hw_all(mbedtls_md_type_t md_type, const void *data, size_t data_size,
+                uint8_t *hash_value)
+{
+    if (hash_value == NULL) {
+        return false;
+    }
+    if (data == NULL && data_size != 0) {
+        return false;
+    }
+    if (data_size > INT_MAX) {
+        return false;
+    }
+
+    if (sha_hw_engine_all(md_type, data, data_size, hash_value)) {
+        return true;
+    }
+
+    return sha_hw_sw_all(md_type, data, data_size, hash_value);
+}
+
+/**
+ * Allocates and initializes one HASH_CTX context for subsequent SHA256 use.
+ *
+ * @return  Pointer to the HASH_CTX context that has been initialized.
+ *         If the allocations fails, libspdm_sha256_new() returns NULL.
+ *
+ **/
+void *libspdm_sha256_new(void)
+{
+    return allocate_zero_pool(sizeof(sha_hw_context_t));
+}
+
+/**
+ * Release the specified HASH_CTX context.
+ *
+ * @param[in]  sha256_ctx  Pointer to the HASH_CTX context to be released.
+ *
+ **/
+void libspdm_sha256_free(void *sha256_ctx)
+{
+    sha_hw_release(sha256_ctx);
+    free_pool(sha256_ctx);
+}
+
+/**
+ * Initializes user-supplied memory pointed by sha256_context as SHA-256 hash context for
+ * subsequent use.
+ *
+ * If sha256_context is NULL, then return false.
+ *
+ * @param[out]  sha256_context  Pointer to SHA-256 context being initialized.
+ *
+ * @retval true   SHA-256 context initialization succeeded.
+ * @retval false  SHA-256 context initialization failed.
+ *
+ **/
+bool libspdm_sha256_init(void *sha256_context)
+{
+    return sha_hw_init(sha256_context, MBEDTLS_MD_SHA256);
+}
+
+/**
+ * Makes a copy of an existing SHA-256 context.
+ *
+ * If sha256_context is NULL, then return false.
+ * If new_sha256_context is NULL, then return false.
+ *
+ * @param[in]  sha256_context     Pointer to SHA-256 context being copied.
+ * @param[out] new_sha256_context  Pointer to new SHA-256 context.
+ *
+ * @retval true   SHA-256 context copy succeeded.
+ * @retval false  SHA-256 context copy failed.
+ *
+ **/
+bool libspdm_sha256_duplicate(const void *sha256_context,
+                              void *new_sha256_context)
+{
+    return sha_hw_duplicate(sha256_context, new_sha256_context);
+}
+
+/**
+ * Digests the input data and updates SHA-256 context.
+ *
+ * This function performs SHA-256 digest on a data buffer of the specified size.
+ * It can be called multiple times to compute the digest of long or discontinuous data streams.
+ * SHA-256 context should be already correctly initialized by libspdm_sha256_init(), and should not be finalized
+ * by libspdm_sha256_final(). Behavior with invalid context is undefined.
+ *
+ * If sha256_context is NULL, then return false.
+ *
+ * @param[in, out]  sha256_context  Pointer to the SHA-256 context.
+ * @param[in]       data           Pointer to the buffer containing the data to be hashed.
+ * @param[in]       data_size       size of data buffer in bytes.
+ *
+ * @retval true   SHA-256 data digest succeeded.
+ * @retval false  SHA-256 data digest failed.
+ *
+ **/
+bool libspdm_sha256_update(void *sha256_context, const void *data,
+                           size_t data_size)
+{
+    return sha_hw_update(sha256_context, data, data_size);
+}
+
+/**
+ * Completes computation of the SHA-256 digest value.
+ *
+ * This function completes SHA-256 hash computation and retrieves the digest value into
+ * the specified memory. After this function has been called, the SHA-256 context cannot
+ * be used again.
+ * SHA-256 context should be already correctly initialized by libspdm_sha256_init(), and should not be
+ * finalized by libspdm_sha256_final(). Behavior with invalid SHA-256 context is undefined.
+ *
+ * If sha256_context is NULL, then return false.
+ * If hash_value is NULL, then return false.
+ *
+ * @param[in, out]  sha256_context  Pointer to the SHA-256 context.
+ * @param[out]      hash_value      Pointer to a buffer that receives the SHA-256 digest
+ *                                value (32 bytes).
+ *
+ * @retval true   SHA-256 digest computation succeeded.
+ * @retval false  SHA-256 digest computation failed.
+ *
+ **/
+bool libspdm_sha256_final(void *sha256_context, uint8_t *hash_value)
+{
+    return sha_hw_final(sha256_context, hash_value);
+}
+
+/**
+ * Computes the SHA-256 message digest of a input data buffer.
+ *
+ * This function performs the SHA-256 message digest of a given data buffer, and places
+ * the digest value into the specified memory.
+ *
+ * If this interface is not supported, then return false.
+ *
+ * @param[in]   data        Pointer to the buffer containing the data to be hashed.
+ * @param[in]   data_size    size of data buffer in bytes.
+ * @param[out]  hash_value   Pointer to a buffer that receives the SHA-256 digest
+ *                         value (32 bytes).
+ *
+ * @retval true   SHA-256 digest computation succeeded.
+ * @retval false  SHA-256 digest computation failed.
+ * @retval false  This interface is not supported.
+ *
+ **/
+bool libspdm_sha256_hash_all(const void *data, size_t data_size,
+                             uint8_t *hash_value)
+{
+    return sha_hw_all(MBEDTLS_MD_SHA256, data, data_size, hash_value);
+}
+
+/**
+ * Allocates and initializes one HASH_CTX context for subsequent SHA384 use.
+ *
+ * @return  Pointer to the HASH_CTX context that has been initialized.
+ *         If the allocations fails, libspdm_sha384_new() returns NULL.
+ *
+ **/
+void *libspdm_sha384_new(void)
+{
+    return allocate_zero_pool(sizeof(sha_hw_context_t));
+}
+
+/**
+ * Release the specified HASH_CTX context.
+ *
+ * @param[in]  sha384_ctx  Pointer to the HASH_CTX context to be released.
+ *
+ **/
+void libspdm_sha384_free(void *sha384_ctx)
+{
+    sha_hw_release(sha384_ctx);
+    free_pool(sha384_ctx);
+}
+
+/**
+ * Initializes user-supplied memory pointed by sha384_context as SHA-384 hash context for
+ * subsequent use.
+ *
+ * If sha384_context is NULL, then return false.
+ *
+ * @param[out]  sha384_context  Pointer to SHA-384 context being initialized.
+ *
+ * @retval true   SHA-384 context initialization succeeded.
+ * @retval false  SHA-384 context initialization failed.
+ *
+ **/
+bool libspdm_sha384_init(void *sha384_context)
+{
+    return sha_hw_init(sha384_context, MBEDTLS_MD_SHA384);
+}
+
+/**
+ * Makes a copy of an existing SHA-384 context.
+ *
+ * If sha384_context is NULL, then return false.
+ * If new_sha384_context is NULL, then return false.
+ * If this interface is not supported, then return false.
+ *
+ * @param[in]  sha384_context     Pointer to SHA-384 context being copied.
+ * @param[out] new_sha384_context  Pointer to new SHA-384 context.
+ *
+ * @retval true   SHA-384 context copy succeeded.
+ * @retval false  SHA-384 context copy failed.
+ * @retval false  This interface is not supported.
+ *
+ **/
+bool libspdm_sha384_duplicate(const void *sha384_context,
+                              void *new_sha384_context)
+{
+    return sha_hw_duplicate(sha384_context, new_sha384_context);
+}
+
+/**
+ * Digests the input data and updates SHA-384 context.
+ *
+ * This function performs SHA-384 digest on a data buffer of the specified size.
+ * It can be called multiple times to compute the digest of long or discontinuous data streams.
+ * SHA-384 context should be already correctly initialized by libspdm_sha384_init(), and should not be finalized
+ * by libspdm_sha384_final(). Behavior with invalid context is undefined.
+ *
+ * If sha384_context is NULL, then return false.
+ *
+ * @param[in, out]  sha384_context  Pointer to the SHA-384 context.
+ * @param[in]       data           Pointer to the buffer containing the data to be hashed.
+ * @param[in]       data_size       size of data buffer in bytes.
+ *
+ * @retval true   SHA-384 data digest succeeded.
+ * @retval false  SHA-384 data digest failed.
+ *
+ **/
+bool libspdm_sha384_update(void *sha384_context, const void *data,
+                           size_t data_size)
+{
+    return sha_hw_update(sha384_context, data, data_size);
+}
+
+/**
+ * Completes computation of the SHA-384 digest value.
+ *
+ * This function completes SHA-384 hash computation and retrieves the digest value into
+ * the specified memory. After this function has been called, the SHA-384 context cannot
+ * be used again.
+ * SHA-384 context should be already correctly initialized by libspdm_sha384_init(), and should not be
+ * finalized by libspdm_sha384_final(). Behavior with invalid SHA-384 context is undefined.
+ *
+ * If sha384_context is NULL, then return false.
+ * If hash_value is NULL, then return false.
+ *
+ * @param[in, out]  sha384_context  Pointer to the SHA-384 context.
+ * @param[out]      hash_value      Pointer to a buffer that receives the SHA-384 digest
+ *                                value (48 bytes).
+ *
+ * @retval true   SHA-384 digest computation succeeded.
+ * @retval false  SHA-384 digest computation failed.
+ *
+ **/
+bool libspdm_sha384_final(void *sha384_context, uint8_t *hash_value)
+{
+    return sha_hw_final(sha384_context, hash_value);
+}
+
+/**
+ * Computes the SHA-384 message digest of a input data buffer.
+ *
+ * This function performs the SHA-384 message digest of a given data buffer, and places
+ * the digest value into the specified memory.
+ *
+ * If this interface is not supported, then return false.
+ *
+ * @param[in]   data        Pointer to the buffer containing the data to be hashed.
+ * @param[in]   data_size    size of data buffer in bytes.
+ * @param[out]  hash_value   Pointer to a buffer that receives the SHA-384 digest
+ *                         value (48 bytes).
+ *
+ * @retval true   SHA-384 digest computation succeeded.
+ * @retval false  SHA-384 digest computation failed.
+ * @retval false  This interface is not supported.
+ *
+ **/
+bool libspdm_sha384_hash_all(const void *data, size_t data_size,
+                             uint8_t *hash_value)
+{
+    return sha_hw_all(MBEDTLS_MD_SHA384, data, data_size, hash_value);
+}
+
+/**
+ * Allocates and initializes one HASH_CTX context for subsequent SHA512 use.
+ *
+ * @return  Pointer to the HASH_CTX context that has been initialized.
+ *         If the allocations fails, libspdm_sha512_new() returns NULL.
+ *
+ **/
+void *libspdm_sha512_new(void)
+{
+    return allocate_zero_pool(sizeof(sha_hw_context_t));
+}
+
+/**
+ * Release the specified HASH_CTX context.
+ *
+ * @param[in]  sha512_ctx  Pointer to the HASH_CTX context to be released.
+ *
+ **/
+void libspdm_sha512_free(void *sha512_ctx)
+{
+    sha_hw_release(sha512_ctx);
+    free_pool(sha512_ctx);
+}
+
+/**
+ * Initializes user-supplied memory pointed by sha512_context as SHA-512 hash context for
+ * subsequent use.
+ *
+ * If sha512_context is NULL, then return false.
+ *
+ * @param[out]  sha512_context  Pointer to SHA-512 context being initialized.
+ *
+ * @retval true   SHA-512 context initialization succeeded.
+ * @retval false  SHA-512 context initialization failed.
+ *
+ **/
+bool libspdm_sha512_init(void *sha512_context)
+{
+    return sha_hw_init(sha512_context, MBEDTLS_MD_SHA512);
+}
+
+/**
+ * Makes a copy of an existing SHA-512 context.
+ *
+ * If sha512_context is NULL, then return false.
+ * If new_sha512_context is NULL, then return false.
+ * If this interface is not supported, then return false.
+ *
+ * @param[in]  sha512_context     Pointer to SHA-512 context being copied.
+ * @param[out] new_sha512_context  Pointer to new SHA-512 context.
+ *
+ * @retval true   SHA-512 context copy succeeded.
+ * @retval false  SHA-512 context copy failed.
+ * @retval false  This interface is not supported.
+ *
+ **/
+bool libspdm_sha512_duplicate(const void *sha512_context,
+                              void *new_sha512_context)
+{
+    return sha_hw_duplicate(sha512_context, new_sha512_context);
+}
+
+/**
+ * Digests the input data and updates SHA-512 context.
+ *
+ * This function performs SHA-512 digest on a data buffer of the specified size.
+ * It can be called multiple times to compute the digest of long or discontinuous data streams.
+ * SHA-512 context should be already correctly initialized by libspdm_sha512_init(), and should not be finalized
+ * by libspdm_sha512_final(). Behavior with invalid context is undefined.
+ *
+ * If sha512_context is NULL, then return false.
+ *
+ * @param[in, out]  sha512_context  Pointer to the SHA-512 context.
+ * @param[in]       data           Pointer to the buffer containing the data to be hashed.
+ * @param[in]       data_size       size of data buffer in bytes.
+ *
+ * @retval true   SHA-512 data digest succeeded.
+ * @retval false  SHA-512 data digest failed.
+ *
+ **/
+bool libspdm_sha512_update(void *sha512_context, const void *data,
+                           size_t data_size)
+{
+    return sha_hw_update(sha512_context, data, data_size);
+}
+
+/**
+ * Completes computation of the SHA-512 digest value.
+ *
+ * This function completes SHA-512 hash computation and retrieves the digest value into
+ * the specified memory. After this function has been called, the SHA-512 context cannot
+ * be used again.
+ * SHA-512 context should be already correctly initialized by libspdm_sha512_init(), and should not be
+ * finalized by libspdm_sha512_final(). Behavior with invalid SHA-512 context is undefined.
+ *
+ * If sha512_context is NULL, then return false.
+ * If hash_value is NULL, then return false.
+ *
+ * @param[in, out]  sha512_context  Pointer to the SHA-512 context.
+ * @param[out]      hash_value      Pointer to a buffer that receives the SHA-512 digest
+ *                                value (64 bytes).
+ *
+ * @retval true   SHA-512 digest computation succeeded.
+ * @retval false  SHA-512 digest computation failed.
+ *
+ **/
+bool libspdm_sha512_final(void *sha512_context, uint8_t *hash_value)
+{
+    return sha_hw_final(sha512_context, hash_value);
+}
+
+/**
+ * Computes the SHA-512 message digest of a input data buffer.
+ *
+ * This function performs the SHA-512 message digest of a given data buffer, and places
+ * the digest value into the specified memory.
+ *
+ * If this interface is not supported, then return false.
+ *
+ * @param[in]   data        Pointer to the buffer containing the data to be hashed.
+ * @param[in]   data_size    size of data buffer in bytes.
+ * @param[out]  hash_value   Pointer to a buffer that receives the SHA-512 digest
+ *                         value (64 bytes).
+ *
+ * @retval true   SHA-512 digest computation succeeded.
+ * @retval false  SHA-512 digest computation failed.
+ * @retval false  This interface is not supported.
+ *
+ **/
+bool libspdm_sha512_hash_all(const void *data, size_t data_size,
+                             uint8_t *hash_value)
+{
+    return sha_hw_all(MBEDTLS_MD_SHA512, data, data_size, hash_value);
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2023 ASPEED Technology Inc.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/** @file
+ * Internal definitions of the hash engine backed SHA-256/384/512 and HMAC wrappers.
+ **/
+
+#ifndef __SHA_ASPEED_H__
+#define __SHA_ASPEED_H__
+
+#include "internal_crypt_lib.h"
+#include <mbedtls/md.h>
+#include <mbedtls/sha256.h>
+#include <mbedtls/sha512.h>
+
+/**
+ * SHA context backed by the hash engine.
+ *
+ * The hash engine can only run one digest at a time and cannot save or restore its state, while
+ * libspdm keeps many digests open and duplicates them. Data is therefore staged in the context
+ * and hashed by the engine in one pass when the digest is finalized. Once the staged data would
+ * exceed CONFIG_DMTF_LIBSPDM_HW_HASH_STAGE_MAX, it is folded into a software context and the
+ * digest is completed in software.
+ **/
+typedef struct {
+    mbedtls_md_type_t md_type;
+    bool sw;
+    uint8_t *stage;
+    size_t stage_size;
+    size_t stage_capacity;
+    union {
+        mbedtls_sha256_context sha256;
+        mbedtls_sha512_context sha512;
+    } sw_ctx;
+} sha_hw_context_t;
+
+size_t sha_hw_get_blocksize(mbedtls_md_type_t md_type);
+size_t sha_hw_get_digest_size(mbedtls_md_type_t md_type);
+
+bool sha_hw_init(sha_hw_context_t *ctx, mbedtls_md_type_t md_type);
+void sha_hw_release(sha_hw_context_t *ctx);
+bool sha_hw_duplicate(const sha_hw_context_t *ctx, sha_hw_context_t *new_ctx);
+bool sha_hw_update(sha_hw_context_t *ctx, const void *data, size_t data_size);
+bool sha_hw_final(sha_hw_context_t *ctx, uint8_t *hash_value);
+bool sha_hw_all(mbedtls_md_type_t md_type, const void *data, size_t data_size,
+                uint8_t *hash_value);
+
+#define HMAC_HW_MAX_BLOCK_SIZE 128
+
+typedef struct {
+    sha_hw_context_t inner;
+    mbedtls_md_type_t md_type;
+    uint8_t opad[HMAC_HW_MAX_BLOCK_SIZE];
+} hmac_hw_context_t;
+
+void hmac_hw_release(hmac_hw_context_t *ctx);
+bool hmac_hw_set_key(mbedtls_md_type_t md_type, void *hmac_ctx,
+                     const uint8_t *key, size_t key_size);
+bool hmac_hw_update(void *hmac_ctx, const void *data, size_t data_size);
+bool hmac_hw_final(void *hmac_ctx, uint8_t *hmac_value);
+
+#endif
@@ -0,0 +1,596 @@
+/*
+ * Copyright (c) 2023 ASPEED Technology Inc.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/** @file
+ * HMAC-SHA256/384/512 Wrapper Implementation on the ASPEED hash engine.
+ *
+ * HMAC is built from the hash engine backed SHA contexts, see sha_hw_context_t:
+ * HMAC(K, m) = H((K0 ^ opad) || H((K0 ^ ipad) || m)).
+ **/
+
+#include "hash/sha_aspeed.h"
+
+static void *hmac_hw_new(void)
+{
+    return allocate_zero_pool(sizeof(hmac_hw_context_t));
+}
+
+void hmac_hw_release(hmac_hw_context_t *ctx)
+{
+    sha_hw_release(&ctx->inner);
+    libspdm_zero_mem(ctx, sizeof(*ctx));
+}
+
+static void hmac_hw_free(void *hmac_ctx)
+{
+    if (hmac_ctx == NULL) {
+        return;
+    }
+
+    hmac_hw_release(hmac_ctx);
+    free_pool(hmac_ctx);
+}
+
+/**
+ * Set user-supplied key for subsequent use. The inner digest is started with the
+ * ipad block and the opad block is kept for hmac_hw_final().
+ **/
+bool hmac_hw_set_key(mbedtls_md_type_t md_type, void *hmac_ctx,
+                     const uint8_t *key, size_t key_size)
+{
+    hmac_hw_context_t *ctx = hmac_ctx;
+    uint8_t key0[HMAC_HW_MAX_BLOCK_SIZE];
+    uint8_t ipad[HMAC_HW_MAX_BLOCK_SIZE];
+    size_t block_size;
+    size_t index;
+    bool ret;
+
+    block_size = sha_hw_get_blocksize(md_type);
+    if (ctx == NULL || block_size == 0 || key_size > INT_MAX) {
+        return false;
+    }
+    if (key == NULL && key_size != 0) {
+        return false;
+    }
+
+    hmac_hw_release(ctx);
+    ctx->md_type = md_type;
+
+    libspdm_zero_mem(key0, sizeof(key0));
+    if (key_size > block_size) {
+        if (!sha_hw_all(md_type, key, key_size, key0)) {
+            return false;
+        }
+    } else if (key_size != 0) {
+        libspdm_copy_mem(key0, sizeof(key0), key, key_size);
+    }
+
+    for (index = 0; index < block_size; index++) {
+        ipad[index] = key0[index] ^ 0x36;
+        ctx->opad[index] = key0[index] ^ 0x5c;
+    }
+
+    ret = sha_hw_init(&ctx->inner, md_type) &&
+          sha_hw_update(&ctx->inner, ipad, block_size);
+
+    libspdm_zero_mem(key0, sizeof(key0));
+    libspdm_zero_mem(ipad, sizeof(ipad));
+
+    return ret;
+}
+
+static bool hmac_hw_duplicate(const void *hmac_ctx, void *new_hmac_ctx)
+{
+    const hmac_hw_context_t *ctx = hmac_ctx;
+    hmac_hw_context_t *new_ctx = new_hmac_ctx;
+
+    if (ctx == NULL || new_ctx == NULL) {
+        return false;
+    }
+
+    hmac_hw_release(new_ctx);
+    if (!sha_hw_duplicate(&ctx->inner, &new_ctx->inner)) {
+        return false;
+    }
+    new_ctx->md_type = ctx->md_type;
+    libspdm_copy_mem(new_ctx->opad, sizeof(new_ctx->opad),
+                     ctx->opad, sizeof(ctx->opad));
+
+    return true;
+}
+
+bool hmac_hw_update(void *hmac_ctx, const void *data, size_t data_size)
+{
+    hmac_hw_context_t *ctx = hmac_ctx;
+
+    if (ctx == NULL) {
+        return false;
+    }
+
+    return sha_hw_update(&ctx->inner, data, data_size);
+}
+
+bool hmac_hw_final(void *hmac_ctx, uint8_t *hmac_value)
+{
+    hmac_hw_context_t *ctx = hmac_ctx;
+    uint8_t outer[HMAC_HW_MAX_BLOCK_SIZE + LIBSPDM_SHA512_DIGEST_SIZE];
+    size_t block_size;
+    size_t digest_size;
+    bool ret;
+
+    if (ctx == NULL || hmac_value == NULL) {
+        return false;
+    }
+
+    block_size = sha_hw_get_blocksize(ctx->md_type);
+    digest_size = sha_hw_get_digest_size(ctx->md_type);
+    if (block_size == 0) {
+        return false;
+    }
+
+    libspdm_copy_mem(outer, sizeof(outer), ctx->opad, block_size);
+    ret = sha_hw_final(&ctx->inner, outer + block_size);
+    if (ret) {
+        ret = sha_hw_all(ctx->md_type, outer, block_size + digest_size, hmac_value);
+    }
+
+    libspdm_zero_mem(outer, sizeof(outer));
+    hmac_hw_release(ctx);
+
+    return ret;
+}
+
+static bool hmac_hw_all(mbedtls_md_type_t md_type, const void *data,
+                        size_t data_size, const uint8_t *key, size_t key_size,
+                        uint8_t *hmac_value)
+{
+    hmac_hw_context_t ctx;
+    bool ret;
+
+    libspdm_zero_mem(&ctx, sizeof(ctx));
+    ret = hmac_hw_set_key(md_type, &ctx, key, key_size) &&
+          hmac_hw_update(&ctx, data, data_size) &&
+          hmac_hw_final(&ctx, hmac_value);
+    hmac_hw_release(&ctx);
+
+    return ret;
+}
+
+/**
+ * Allocates and initializes one HMAC_CTX context for subsequent HMAC-SHA256 use.
+ *
+ * @return  Pointer to the HMAC_CTX context that has been initialized.
+ *         If the allocations fails, libspdm_hmac_sha256_new() returns NULL.
+ *
+ **/
+void *libspdm_hmac_sha256_new(void)
+{
+    return hmac_hw_new();
+}
+
+/**
+ * Release the specified HMAC_CTX context.
+ *
+ * @param[in]  hmac_sha256_ctx  Pointer to the HMAC_CTX context to be released.
+ *
+ **/
+void libspdm_hmac_sha256_free(void *hmac_sha256_ctx)
+{
+    hmac_hw_free(hmac_sha256_ctx);
+}
+
+/**
+ * Set user-supplied key for subsequent use. It must be done before any
+ * calling to libspdm_hmac_sha256_update().
+ *
+ * If hmac_sha256_ctx is NULL, then return false.
+ *
+ * @param[out]  hmac_sha256_ctx  Pointer to HMAC-SHA256 context.
+ * @param[in]   key                Pointer to the user-supplied key.
+ * @param[in]   key_size            key size in bytes.
+ *
+ * @retval true   The key is set successfully.
+ * @retval false  The key is set unsuccessfully.
+ *
+ **/
+bool libspdm_hmac_sha256_set_key(void *hmac_sha256_ctx, const uint8_t *key,
+                                 size_t key_size)
+{
+    return hmac_hw_set_key(MBEDTLS_MD_SHA256, hmac_sha256_ctx, key,
+                           key_size);
+}
+
+/**
+ * Makes a copy of an existing HMAC-SHA256 context.
+ *
+ * If hmac_sha256_ctx is NULL, then return false.
+ * If new_hmac_sha256_ctx is NULL, then return false.
+ *
+ * @param[in]  hmac_sha256_ctx     Pointer to HMAC-SHA256 context being copied.
+ * @param[out] new_hmac_sha256_ctx  Pointer to new HMAC-SHA256 context.
+ *
+ * @retval true   HMAC-SHA256 context copy succeeded.
+ * @retval false  HMAC-SHA256 context copy failed.
+ *
+ **/
+bool libspdm_hmac_sha256_duplicate(const void *hmac_sha256_ctx,
+                                   void *new_hmac_sha256_ctx)
+{
+    return hmac_hw_duplicate(hmac_sha256_ctx, new_hmac_sha256_ctx);
+}
+
+/**
+ * Digests the input data and updates HMAC-SHA256 context.
+ *
+ * This function performs HMAC-SHA256 digest on a data buffer of the specified size.
+ * It can be called multiple times to compute the digest of long or discontinuous data streams.
+ * HMAC-SHA256 context should be initialized by libspdm_hmac_sha256_new(), and should not be finalized
+ * by libspdm_hmac_sha256_final(). Behavior with invalid context is undefined.
+ *
+ * If hmac_sha256_ctx is NULL, then return false.
+ *
+ * @param[in, out]  hmac_sha256_ctx Pointer to the HMAC-SHA256 context.
+ * @param[in]       data              Pointer to the buffer containing the data to be digested.
+ * @param[in]       data_size          size of data buffer in bytes.
+ *
+ * @retval true   HMAC-SHA256 data digest succeeded.
+ * @retval false  HMAC-SHA256 data digest failed.
+ *
+ **/
+bool libspdm_hmac_sha256_update(void *hmac_sha256_ctx, const void *data,
+                                size_t data_size)
+{
+    return hmac_hw_update(hmac_sha256_ctx, data, data_size);
+}
+
+/**
+ * Completes computation of the HMAC-SHA256 digest value.
+ *
+ * This function completes HMAC-SHA256 hash computation and retrieves the digest value into
+ * the specified memory. After this function has been called, the HMAC-SHA256 context cannot
+ * be used again.
+ * HMAC-SHA256 context should be initialized by libspdm_hmac_sha256_new(), and should not be finalized
+ * by libspdm_hmac_sha256_final(). Behavior with invalid HMAC-SHA256 context is undefined.
+ *
+ * If hmac_sha256_ctx is NULL, then return false.
+ * If hmac_value is NULL, then return false.
+ *
+ * @param[in, out]  hmac_sha256_ctx  Pointer to the HMAC-SHA256 context.
+ * @param[out]      hmac_value          Pointer to a buffer that receives the HMAC-SHA256 digest
+ *                                    value (32 bytes).
+ *
+ * @retval true   HMAC-SHA256 digest computation succeeded.
+ * @retval false  HMAC-SHA256 digest computation failed.
+ *
+ **/
+bool libspdm_hmac_sha256_final(void *hmac_sha256_ctx, uint8_t *hmac_value)
+{
+    return hmac_hw_final(hmac_sha256_ctx, hmac_value);
+}
+
+/**
+ * Computes the HMAC-SHA256 digest of a input data buffer.
+ *
+ * This function performs the HMAC-SHA256 digest of a given data buffer, and places
+ * the digest value into the specified memory.
+ *
+ * If this interface is not supported, then return false.
+ *
+ * @param[in]   data        Pointer to the buffer containing the data to be digested.
+ * @param[in]   data_size    size of data buffer in bytes.
+ * @param[in]   key         Pointer to the user-supplied key.
+ * @param[in]   key_size     key size in bytes.
+ * @param[out]  hash_value   Pointer to a buffer that receives the HMAC-SHA256 digest
+ *                         value (32 bytes).
+ *
+ * @retval true   HMAC-SHA256 digest computation succeeded.
+ * @retval false  HMAC-SHA256 digest computation failed.
+ * @retval false  This interface is not supported.
+ *
+ **/
+bool libspdm_hmac_sha256_all(const void *data, size_t data_size,
+                             const uint8_t *key, size_t key_size,
+                             uint8_t *hmac_value)
+{
+    return hmac_hw_all(MBEDTLS_MD_SHA256, data, data_size, key, key_size,
+                       hmac_value);
+}
+
+/**
+ * Allocates and initializes one HMAC_CTX context for subsequent HMAC-SHA384 use.
+ *
+ * @return  Pointer to the HMAC_CTX context that has been initialized.
+ *         If the allocations fails, libspdm_hmac_sha384_new() returns NULL.
+ *
+ **/
+void *libspdm_hmac_sha384_new(void)
+{
+    return hmac_hw_new();
+}
+
+/**
+ * Release the specified HMAC_CTX context.
+ *
+ * @param[in]  hmac_sha384_ctx  Pointer to the HMAC_CTX context to be released.
+ *
+ **/
+void libspdm_hmac_sha384_free(void *hmac_sha384_ctx)
+{
+    hmac_hw_free(hmac_sha384_ctx);
+}
+
+/**
+ * Set user-supplied key for subsequent use. It must be done before any
+ * calling to libspdm_hmac_sha384_update().
+ *
+ * If hmac_sha384_ctx is NULL, then return false.
+ * If this interface is not supported, then return false.
+ *
+ * @param[out]  hmac_sha384_ctx  Pointer to HMAC-SHA384 context.
+ * @param[in]   key                Pointer to the user-supplied key.
+ * @param[in]   key_size            key size in bytes.
+ *
+ * @retval true   The key is set successfully.
+ * @retval false  The key is set unsuccessfully.
+ * @retval false  This interface is not supported.
+ *
+ **/
+bool libspdm_hmac_sha384_set_key(void *hmac_sha384_ctx, const uint8_t *key,
+                                 size_t key_size)
+{
+    return hmac_hw_set_key(MBEDTLS_MD_SHA384, hmac_sha384_ctx, key,
+                           key_size);
+}
+
+/**
+ * Makes a copy of an existing HMAC-SHA384 context.
+ *
+ * If hmac_sha384_ctx is NULL, then return false.
+ * If new_hmac_sha384_ctx is NULL, then return false.
+ * If this interface is not supported, then return false.
+ *
+ * @param[in]  hmac_sha384_ctx     Pointer to HMAC-SHA384 context being copied.
+ * @param[out] new_hmac_sha384_ctx  Pointer to new HMAC-SHA384 context.
+ *
+ * @retval true   HMAC-SHA384 context copy succeeded.
+ * @retval false  HMAC-SHA384 context copy failed.
+ * @retval false  This interface is not supported.
+ *
+ **/
+bool libspdm_hmac_sha384_duplicate(const void *hmac_sha384_ctx,
+                                   void *new_hmac_sha384_ctx)
+{
+    return hmac_hw_duplicate(hmac_sha384_ctx, new_hmac_sha384_ctx);
+}
+
+/**
+ * Digests the input data and updates HMAC-SHA384 context.
+ *
+ * This function performs HMAC-SHA384 digest on a data buffer of the specified size.
+ * It can be called multiple times to compute the digest of long or discontinuous data streams.
+ * HMAC-SHA384 context should be initialized by libspdm_hmac_sha384_new(), and should not be finalized
+ * by libspdm_hmac_sha384_final(). Behavior with invalid context is undefined.
+ *
+ * If hmac_sha384_ctx is NULL, then return false.
+ * If this interface is not supported, then return false.
+ *
+ * @param[in, out]  hmac_sha384_ctx Pointer to the HMAC-SHA384 context.
+ * @param[in]       data              Pointer to the buffer containing the data to be digested.
+ * @param[in]       data_size          size of data buffer in bytes.
+ *
+ * @retval true   HMAC-SHA384 data digest succeeded.
+ * @retval false  HMAC-SHA384 data digest failed.
+ * @retval false  This interface is not supported.
+ *
+ **/
+bool libspdm_hmac_sha384_update(void *hmac_sha384_ctx, const void *data,
+                                size_t data_size)
+{
+    return hmac_hw_update(hmac_sha384_ctx, data, data_size);
+}
+
+/**
+ * Completes computation of the HMAC-SHA384 digest value.
+ *
+ * This function completes HMAC-SHA384 hash computation and retrieves the digest value into
+ * the specified memory. After this function has been called, the HMAC-SHA384 context cannot
+ * be used again.
+ * HMAC-SHA384 context should be initialized by libspdm_hmac_sha384_new(), and should not be finalized
+ * by libspdm_hmac_sha384_final(). Behavior with invalid HMAC-SHA384 context is undefined.
+ *
+ * If hmac_sha384_ctx is NULL, then return false.
+ * If hmac_value is NULL, then return false.
+ * If this interface is not supported, then return false.
+ *
+ * @param[in, out]  hmac_sha384_ctx  Pointer to the HMAC-SHA384 context.
+ * @param[out]      hmac_value          Pointer to a buffer that receives the HMAC-SHA384 digest
+ *                                    value (48 bytes).
+ *
+ * @retval true   HMAC-SHA384 digest computation succeeded.
+ * @retval false  HMAC-SHA384 digest computation failed.
+ * @retval false  This interface is not supported.
+ *
+ **/
+bool libspdm_hmac_sha384_final(void *hmac_sha384_ctx, uint8_t *hmac_value)
+{
+    return hmac_hw_final(hmac_sha384_ctx, hmac_value);
+}
+
+/**
+ * Computes the HMAC-SHA384 digest of a input data buffer.
+ *
+ * This function performs the HMAC-SHA384 digest of a given data buffer, and places
+ * the digest value into the specified memory.
+ *
+ * If this interface is not supported, then return false.
+ *
+ * @param[in]   data        Pointer to the buffer containing the data to be digested.
+ * @param[in]   data_size    size of data buffer in bytes.
+ * @param[in]   key         Pointer to the user-supplied key.
+ * @param[in]   key_size     key size in bytes.
+ * @param[out]  hash_value   Pointer to a buffer that receives the HMAC-SHA384 digest
+ *                         value (48 bytes).
+ *
+ * @retval true   HMAC-SHA384 digest computation succeeded.
+ * @retval false  HMAC-SHA384 digest computation failed.
+ * @retval false  This interface is not supported.
+ *
+ **/
+bool libspdm_hmac_sha384_all(const void *data, size_t data_size,
+                             const uint8_t *key, size_t key_size,
+                             uint8_t *hmac_value)
+{
+    return hmac_hw_all(MBEDTLS_MD_SHA384, data, data_size, key, key_size,
+                       hmac_value);
+}
+
+/**
+ * Allocates and initializes one HMAC_CTX context for subsequent HMAC-SHA512 use.
+ *
+ * @return  Pointer to the HMAC_CTX context that has been initialized.
+ *         If the allocations fails, libspdm_hmac_sha512_new() returns NULL.
+ *
+ **/
+void *libspdm_hmac_sha512_new(void)
+{
+    return hmac_hw_new();
+}
+
+/**
+ * Release the specified HMAC_CTX context.
+ *
+ * @param[in]  hmac_sha512_ctx  Pointer to the HMAC_CTX context to be released.
+ *
+ **/
+void libspdm_hmac_sha512_free(void *hmac_sha512_ctx)
+{
+    hmac_hw_free(hmac_sha512_ctx);
+}
+
+/**
+ * Set user-supplied key for subsequent use. It must be done before any
+ * calling to libspdm_hmac_sha512_update().
+ *
+ * If hmac_sha512_ctx is NULL, then return false.
+ * If this interface is not supported, then return false.
+ *
+ * @param[out]  hmac_sha512_ctx  Pointer to HMAC-SHA512 context.
+ * @param[in]   key                Pointer to the user-supplied key.
+ * @param[in]   key_size            key size in bytes.
+ *
+ * @retval true   The key is set successfully.
+ * @retval false  The key is set unsuccessfully.
+ * @retval false  This interface is not supported.
+ *
+ **/
+bool libspdm_hmac_sha512_set_key(void *hmac_sha512_ctx, const uint8_t *key,
+                                 size_t key_size)
+{
+    return hmac_hw_set_key(MBEDTLS_MD_SHA512, hmac_sha512_ctx, key,
+                           key_size);
+}
+
+/**
+ * Makes a copy of an existing HMAC-SHA512 context.
+ *
+ * If hmac_sha512_ctx is NULL, then return false.
+ * If new_hmac_sha512_ctx is NULL, then return false.
+ * If this interface is not supported, then return false.
+ *
+ * @param[in]  hmac_sha512_ctx     Pointer to HMAC-SHA512 context being copied.
+ * @param[out] new_hmac_sha512_ctx  Pointer to new HMAC-SHA512 context.
+ *
+ * @retval true   HMAC-SHA512 context copy succeeded.
+ * @retval false  HMAC-SHA512 context copy failed.
+ * @retval false  This interface is not supported.
+ *
+ **/
+bool libspdm_hmac_sha512_duplicate(const void *hmac_sha512_ctx,
+                                   void *new_hmac_sha512_ctx)
+{
+    return hmac_hw_duplicate(hmac_sha512_ctx, new_hmac_sha512_ctx);
+}
+
+/**
+ * Digests the input data and updates HMAC-SHA512 context.
+ *
+ * This function performs HMAC-SHA512 digest on a data buffer of the specified size.
+ * It can be called multiple times to compute the digest of long or discontinuous data streams.
+ * HMAC-SHA512 context should be initialized by libspdm_hmac_sha512_new(), and should not be finalized
+ * by libspdm_hmac_sha512_final(). Behavior with invalid context is undefined.
+ *
+ * If hmac_sha512_ctx is NULL, then return false.
+ * If this interface is not supported, then return false.
+ *
+ * @param[in, out]  hmac_sha512_ctx Pointer to the HMAC-SHA512 context.
+ * @param[in]       data              Pointer to the buffer containing the data to be digested.
+ * @param[in]       data_size          size of data buffer in bytes.
+ *
+ * @retval true   HMAC-SHA512 data digest succeeded.
+ * @retval false  HMAC-SHA512 data digest failed.
+ * @retval false  This interface is not supported.
+ *
+ **/
+bool libspdm_hmac_sha512_update(void *hmac_sha512_ctx, const void *data,
+                                size_t data_size)
+{
+    return hmac_hw_update(hmac_sha512_ctx, data, data_size);
+}
+
+/**
+ * Completes computation of the HMAC-SHA512 digest value.
+ *
+ * This function completes HMAC-SHA512 hash computation and retrieves the digest value into
+ * the specified memory. After this function has been called, the HMAC-SHA512 context cannot
+ * be used again.
+ * HMAC-SHA512 context should be initialized by libspdm_hmac_sha512_new(), and should not be finalized
+ * by libspdm_hmac_sha512_final(). Behavior with invalid HMAC-SHA512 context is undefined.
+ *
+ * If hmac_sha512_ctx is NULL, then return false.
+ * If hmac_value is NULL, then return false.
+ * If this interface is not supported, then return false.
+ *
+ * @param[in, out]  hmac_sha512_ctx  Pointer to the HMAC-SHA512 context.
+ * @param[out]      hmac_value          Pointer to a buffer that receives the HMAC-SHA512 digest
+ *                                    value (64 bytes).
+ *
+ * @retval true   HMAC-SHA512 digest computation succeeded.
+ * @retval false  HMAC-SHA512 digest computation failed.
+ * @retval false  This interface is not supported.
+ *
+ **/
+bool libspdm_hmac_sha512_final(void *hmac_sha512_ctx, uint8_t *hmac_value)
+{
+    return hmac_hw_final(hmac_sha512_ctx, hmac_value);
+}
+
+/**
+ * Computes the HMAC-SHA512 digest of a input data buffer.
+ *
+ * This function performs the HMAC-SHA512 digest of a given data buffer, and places
+ * the digest value into the specified memory.
+ *
+ * If this interface is not supported, then return false.
+ *
+ * @param[in]   data        Pointer to the buffer containing the data to be digested.
+ * @param[in]   data_size    size of data buffer in bytes.
+ * @param[in]   key         Pointer to the user-supplied key.
+ * @param[in]   key_size     key size in bytes.
+ * @param[out]  hash_value   Pointer to a buffer that receives the HMAC-SHA512 digest
+ *                         value (64 bytes).
+ *
+ * @retval true   HMAC-SHA512 digest computation succeeded.
+ * @retval false  HMAC-SHA512 digest computation failed.
+ * @retval false  This interface is not supported.
+ *
+ **/
+bool libspdm_hmac_sha512_all(const void *data, size_t data_size,
+                             const uint8_t *key, size_t key_size,
+                             uint8_t *hmac_value)
+{
+    return hmac_hw_all(MBEDTLS_MD_SHA512, data, data_size, key, key_size,
+                       hmac_value);
+}
@@ -0,0 +1,324 @@
+/*
+ * Copyright (c) 2023 ASPEED Technology Inc.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/** @file
+ * HMAC-SHA256/384/512 KDF Wrapper Implementation on the ASPEED hash engine.
+ *
+ * RFC 5869: HMAC-based Extract-and-Expand key Derivation Function (HKDF)
+ **/
+
+#include <sys/util.h>
+#include "hash/sha_aspeed.h"
+
+/**
+ * HKDF-Extract: PRK = HMAC-Hash(salt, IKM).
+ **/
+static bool hkdf_hw_extract(const mbedtls_md_type_t md_type, const uint8_t *key,
+                            size_t key_size, const uint8_t *salt,
+                            size_t salt_size, uint8_t *prk_out,
+                            size_t prk_out_size)
+{
+    hmac_hw_context_t ctx;
+    bool ret;
+
+    if (key == NULL || salt == NULL || prk_out == NULL ||
+        key_size > INT_MAX || salt_size > INT_MAX ||
+        prk_out_size > INT_MAX) {
+        return false;
+    }
+
+    if (prk_out_size != sha_hw_get_digest_size(md_type)) {
+        return false;
+    }
+
+    libspdm_zero_mem(&ctx, sizeof(ctx));
+    ret = hmac_hw_set_key(md_type, &ctx, salt, salt_size) &&
+          hmac_hw_update(&ctx, key, key_size) &&
+          hmac_hw_final(&ctx, prk_out);
+    hmac_hw_release(&ctx);
+
+    return ret;
+}
+
+/**
+ * HKDF-Expand: T(i) = HMAC-Hash(PRK, T(i - 1) || info || i), OKM = T(1) || T(2) || ...
+ **/
+static bool hkdf_hw_expand(const mbedtls_md_type_t md_type, const uint8_t *prk,
+                           size_t prk_size, const uint8_t *info,
+                           size_t info_size, uint8_t *out, size_t out_size)
+{
+    hmac_hw_context_t ctx;
+    uint8_t block[LIBSPDM_SHA512_DIGEST_SIZE];
+    size_t digest_size;
+    size_t block_size;
+    size_t offset;
+    uint8_t counter;
+    bool ret;
+
+    if (prk == NULL || info == NULL || out == NULL || prk_size > INT_MAX ||
+        info_size > INT_MAX || out_size > INT_MAX) {
+        return false;
+    }
+
+    digest_size = sha_hw_get_digest_size(md_type);
+    if (digest_size == 0 || prk_size != digest_size) {
+        return false;
+    }
+    if (out_size > 255 * digest_size) {
+        return false;
+    }
+
+    libspdm_zero_mem(&ctx, sizeof(ctx));
+    ret = true;
+    block_size = 0;
+    counter = 0;
+    for (offset = 0; ret && offset < out_size; offset += block_size) {
+        counter++;
+        ret = hmac_hw_set_key(md_type, &ctx, prk, prk_size) &&
+              hmac_hw_update(&ctx, block, block_size) &&
+              hmac_hw_update(&ctx, info, info_size) &&
+              hmac_hw_update(&ctx, &counter, sizeof(counter)) &&
+              hmac_hw_final(&ctx, block);
+        block_size = digest_size;
+        if (ret) {
+            libspdm_copy_mem(out + offset, out_size - offset, block,
+                             MIN(block_size, out_size - offset));
+        }
+    }
+
+    hmac_hw_release(&ctx);
+    libspdm_zero_mem(block, sizeof(block));
+
+    return ret;
+}
+
+static bool hkdf_hw_extract_and_expand(const mbedtls_md_type_t md_type,
+                                       const uint8_t *key, size_t key_size,
+                                       const uint8_t *salt, size_t salt_size,
+                                       const uint8_t *info, size_t info_size,
+                                       uint8_t *out, size_t out_size)
+{
+    uint8_t prk[LIBSPDM_SHA512_DIGEST_SIZE];
+    size_t prk_size;
+    bool ret;
+
+    prk_size = sha_hw_get_digest_size(md_type);
+    ret = hkdf_hw_extract(md_type, key, key_size, salt, salt_size, prk, prk_size) &&
+          hkdf_hw_expand(md_type, prk, prk_size, info, info_size, out, out_size);
+    libspdm_zero_mem(prk, sizeof(prk));
+
+    return ret;
+}
+
+/**
+ * Derive SHA256 HMAC-based Extract-and-Expand key Derivation Function (HKDF).
+ *
+ * @param[in]   key              Pointer to the user-supplied key.
+ * @param[in]   key_size          key size in bytes.
+ * @param[in]   salt             Pointer to the salt(non-secret) value.
+ * @param[in]   salt_size         salt size in bytes.
+ * @param[in]   info             Pointer to the application specific info.
+ * @param[in]   info_size         info size in bytes.
+ * @param[out]  out              Pointer to buffer to receive hkdf value.
+ * @param[in]   out_size          size of hkdf bytes to generate.
+ *
+ * @retval true   Hkdf generated successfully.
+ * @retval false  Hkdf generation failed.
+ *
+ **/
+bool libspdm_hkdf_sha256_extract_and_expand(const uint8_t *key, size_t key_size,
+                                            const uint8_t *salt, size_t salt_size,
+                                            const uint8_t *info, size_t info_size,
+                                            uint8_t *out, size_t out_size)
+{
+    return hkdf_hw_extract_and_expand(MBEDTLS_MD_SHA256, key, key_size,
+                                      salt, salt_size, info, info_size, out,
+                                      out_size);
+}
+
+/**
+ * Derive SHA256 HMAC-based Extract key Derivation Function (HKDF).
+ *
+ * @param[in]   key              Pointer to the user-supplied key.
+ * @param[in]   key_size          key size in bytes.
+ * @param[in]   salt             Pointer to the salt(non-secret) value.
+ * @param[in]   salt_size         salt size in bytes.
+ * @param[out]  prk_out           Pointer to buffer to receive hkdf value.
+ * @param[in]   prk_out_size       size of hkdf bytes to generate.
+ *
+ * @retval true   Hkdf generated successfully.
+ * @retval false  Hkdf generation failed.
+ *
+ **/
+bool libspdm_hkdf_sha256_extract(const uint8_t *key, size_t key_size,
+                                 const uint8_t *salt, size_t salt_size,
+                                 uint8_t *prk_out, size_t prk_out_size)
+{
+    return hkdf_hw_extract(MBEDTLS_MD_SHA256, key, key_size, salt,
+                           salt_size, prk_out, prk_out_size);
+}
+
+/**
+ * Derive SHA256 HMAC-based Expand key Derivation Function (HKDF).
+ *
+ * @param[in]   prk              Pointer to the user-supplied key.
+ * @param[in]   prk_size          key size in bytes.
+ * @param[in]   info             Pointer to the application specific info.
+ * @param[in]   info_size         info size in bytes.
+ * @param[out]  out              Pointer to buffer to receive hkdf value.
+ * @param[in]   out_size          size of hkdf bytes to generate.
+ *
+ * @retval true   Hkdf generated successfully.
+ * @retval false  Hkdf generation failed.
+ *
+ **/
+bool libspdm_hkdf_sha256_expand(const uint8_t *prk, size_t prk_size,
+                                const uint8_t *info, size_t info_size,
+                                uint8_t *out, size_t out_size)
+{
+    return hkdf_hw_expand(MBEDTLS_MD_SHA256, prk, prk_size, info, info_size,
+                          out, out_size);
+}
+
+/**
+ * Derive SHA384 HMAC-based Extract-and-Expand key Derivation Function (HKDF).
+ *
+ * @param[in]   key              Pointer to the user-supplied key.
+ * @param[in]   key_size          key size in bytes.
+ * @param[in]   salt             Pointer to the salt(non-secret) value.
+ * @param[in]   salt_size         salt size in bytes.
+ * @param[in]   info             Pointer to the application specific info.
+ * @param[in]   info_size         info size in bytes.
+ * @param[out]  out              Pointer to buffer to receive hkdf value.
+ * @param[in]   out_size          size of hkdf bytes to generate.
+ *
+ * @retval true   Hkdf generated successfully.
+ * @retval false  Hkdf generation failed.
+ *
+ **/
+bool libspdm_hkdf_sha384_extract_and_expand(const uint8_t *key, size_t key_size,
+                                            const uint8_t *salt, size_t salt_size,
+                                            const uint8_t *info, size_t info_size,
+                                            uint8_t *out, size_t out_size)
+{
+    return hkdf_hw_extract_and_expand(MBEDTLS_MD_SHA384, key, key_size,
+                                      salt, salt_size, info, info_size, out,
+                                      out_size);
+}
+
+/**
+ * Derive SHA384 HMAC-based Extract key Derivation Function (HKDF).
+ *
+ * @param[in]   key              Pointer to the user-supplied key.
+ * @param[in]   key_size          key size in bytes.
+ * @param[in]   salt             Pointer to the salt(non-secret) value.
+ * @param[in]   salt_size         salt size in bytes.
+ * @param[out]  prk_out           Pointer to buffer to receive hkdf value.
+ * @param[in]   prk_out_size       size of hkdf bytes to generate.
+ *
+ * @retval true   Hkdf generated successfully.
+ * @retval false  Hkdf generation failed.
+ *
+ **/
+bool libspdm_hkdf_sha384_extract(const uint8_t *key, size_t key_size,
+                                 const uint8_t *salt, size_t salt_size,
+                                 uint8_t *prk_out, size_t prk_out_size)
+{
+    return hkdf_hw_extract(MBEDTLS_MD_SHA384, key, key_size, salt,
+                           salt_size, prk_out, prk_out_size);
+}
+
+/**
+ * Derive SHA384 HMAC-based Expand key Derivation Function (HKDF).
+ *
+ * @param[in]   prk              Pointer to the user-supplied key.
+ * @param[in]   prk_size          key size in bytes.
+ * @param[in]   info             Pointer to the application specific info.
+ * @param[in]   info_size         info size in bytes.
+ * @param[out]  out              Pointer to buffer to receive hkdf value.
+ * @param[in]   out_size          size of hkdf bytes to generate.
+ *
+ * @retval true   Hkdf generated successfully.
+ * @retval false  Hkdf generation failed.
+ *
+ **/
+bool libspdm_hkdf_sha384_expand(const uint8_t *prk, size_t prk_size,
+                                const uint8_t *info, size_t info_size,
+                                uint8_t *out, size_t out_size)
+{
+    return hkdf_hw_expand(MBEDTLS_MD_SHA384, prk, prk_size, info, info_size,
+                          out, out_size);
+}
+
+/**
+ * Derive SHA512 HMAC-based Extract-and-Expand key Derivation Function (HKDF).
+ *
+ * @param[in]   key              Pointer to the user-supplied key.
+ * @param[in]   key_size          key size in bytes.
+ * @param[in]   salt             Pointer to the salt(non-secret) value.
+ * @param[in]   salt_size         salt size in bytes.
+ * @param[in]   info             Pointer to the application specific info.
+ * @param[in]   info_size         info size in bytes.
+ * @param[out]  out              Pointer to buffer to receive hkdf value.
+ * @param[in]   out_size          size of hkdf bytes to generate.
+ *
+ * @retval true   Hkdf generated successfully.
+ * @retval false  Hkdf generation failed.
+ *
+ **/
+bool libspdm_hkdf_sha512_extract_and_expand(const uint8_t *key, size_t key_size,
+                                            const uint8_t *salt, size_t salt_size,
+                                            const uint8_t *info, size_t info_size,
+                                            uint8_t *out, size_t out_size)
+{
+    return hkdf_hw_extract_and_expand(MBEDTLS_MD_SHA512, key, key_size,
+                                      salt, salt_size, info, info_size, out,
+                                      out_size);
+}
+
+/**
+ * Derive SHA512 HMAC-based Extract key Derivation Function (HKDF).
+ *
+ * @param[in]   key              Pointer to the user-supplied key.
+ * @param[in]   key_size          key size in bytes.
+ * @param[in]   salt             Pointer to the salt(non-secret) value.
+ * @param[in]   salt_size         salt size in bytes.
+ * @param[out]  prk_out           Pointer to buffer to receive hkdf value.
+ * @param[in]   prk_out_size       size of hkdf bytes to generate.
+ *
+ * @retval true   Hkdf generated successfully.
+ * @retval false  Hkdf generation failed.
+ *
+ **/
+bool libspdm_hkdf_sha512_extract(const uint8_t *key, size_t key_size,
+                                 const uint8_t *salt, size_t salt_size,
+                                 uint8_t *prk_out, size_t prk_out_size)
+{
+    return hkdf_hw_extract(MBEDTLS_MD_SHA512, key, key_size, salt,
+                           salt_size, prk_out, prk_out_size);
+}
+
+/**
+ * Derive SHA512 HMAC-based Expand key Derivation Function (HKDF).
+ *
+ * @param[in]   prk              Pointer to the user-supplied key.
+ * @param[in]   prk_size          key size in bytes.
+ * @param[in]   info             Pointer to the application specific info.
+ * @param[in]   info_size         info size in bytes.
+ * @param[out]  out              Pointer to buffer to receive hkdf value.
+ * @param[in]   out_size          size of hkdf bytes to generate.
+ *
+ * @retval true   Hkdf generated successfully.
+ * @retval false  Hkdf generation failed.
+ *
+ **/
+bool libspdm_hkdf_sha512_expand(const uint8_t *prk, size_t prk_size,
+                                const uint8_t *info, size_t info_size,
+                                uint8_t *out, size_t out_size)
+{
+    return hkdf_hw_expand(MBEDTLS_MD_SHA512, prk, prk_size, info, info_size,
+                          out, out_size);
+}
@@ -10,8 +10,319 @@
 #include <crypto/hash_structs.h>
 #include <crypto/hash.h>
 #include "hash_aspeed.h"
+#include "hash_engine_lock.h"
+#if defined(CONFIG_MBEDTLS)
+#include <mbedtls/sha1.h>
+#include <mbedtls/sha256.h>
+#include <mbedtls/sha512.h>
+#endif
+
+/**
+ * A hash session is either bound to the hash engine or, when the engine is already owned by
+ * another session or by the libspdm cryptlib (see hash_engine_lock.h), computed in software. Software sessions keep their whole digest state in
+ * the session itself, so any number of them can be interleaved with the hardware session.
+ */
+struct hash_session {
+	bool in_use;
+	bool hw;
+	enum hash_algo algo;
+	struct hash_params params;
+#if defined(CONFIG_MBEDTLS)
+	union {
+#if defined(MBEDTLS_SHA1_C)
+		mbedtls_sha1_context sha1;
+#endif
+#if defined(MBEDTLS_SHA256_C)
+		mbedtls_sha256_context sha256;
+#endif
+#if defined(MBEDTLS_SHA512_C)
+		mbedtls_sha512_context sha512;
+#endif
+	} sw;
+#endif
+};
+
+static struct hash_session hash_session_pool[CONFIG_HASH_SESSION_POOL_SIZE];
+static struct hash_session *hash_hw_owner;	// session currently bound to the hash engine
+static struct hash_session *legacy_session;	// session used by hash_engine_start/update/finish
+K_MUTEX_DEFINE(hash_session_mutex);
+// Counts the free pool entries, a full pool makes hash_engine_session_start wait
+K_SEM_DEFINE(hash_session_free_sem, CONFIG_HASH_SESSION_POOL_SIZE, CONFIG_HASH_SESSION_POOL_SIZE);
+// Held by the thread running a hash_engine_start/update/finish sequence
+K_MUTEX_DEFINE(hash_legacy_mutex);
+
+static int hash_sw_start(struct hash_session *session, enum hash_algo algo)
+{
+#if defined(CONFIG_MBEDTLS)
+	switch (algo) {
+#if defined(MBEDTLS_SHA1_C)
+	case HASH_SHA1:
+		mbedtls_sha1_init(&session->sw.sha1);
+		return mbedtls_sha1_starts(&session->sw.sha1);
+#endif
+#if defined(MBEDTLS_SHA256_C)
+	case HASH_SHA256:
+		mbedtls_sha256_init(&session->sw.sha256);
+		return mbedtls_sha256_starts(&session->sw.sha256, 0);
+#endif
+#if defined(MBEDTLS_SHA512_C)
+	case HASH_SHA384:
+	case HASH_SHA512:
+		mbedtls_sha512_init(&session->sw.sha512);
+		return mbedtls_sha512_starts(&session->sw.sha512, algo == HASH_SHA384);
+#endif
+	default:
+		break;
+	}
+#endif
+	ARG_UNUSED(session);
+	ARG_UNUSED(algo);
+
+	return -EBUSY;
+}
+
+static int hash_sw_update(struct hash_session *session, const uint8_t *data, size_t length)
+{
+#if defined(CONFIG_MBEDTLS)
+	switch (session->algo) {
+#if defined(MBEDTLS_SHA1_C)
+	case HASH_SHA1:
+		return mbedtls_sha1_update(&session->sw.sha1, data, length);
+#endif
+#if defined(MBEDTLS_SHA256_C)
+	case HASH_SHA256:
+		return mbedtls_sha256_update(&session->sw.sha256, data, length);
+#endif
+#if defined(MBEDTLS_SHA512_C)
+	case HASH_SHA384:
+	case HASH_SHA512:
+		return mbedtls_sha512_update(&session->sw.sha512, data, length);
+#endif
+	default:
+		break;
+	}
+#endif
+	ARG_UNUSED(data);
+	ARG_UNUSED(length);
+
+	return -EINVAL;
+}
+
+static size_t hash_digest_length(enum hash_algo algo)
+{
+	switch (algo) {
+	case HASH_SHA1:
+		return 20;
+	case HASH_SHA256:
+		return 32;
+	case HASH_SHA384:
+		return 48;
+	case HASH_SHA512:
+		return 64;
+	default:
+		return 0;
+	}
+}
+
+static int hash_sw_finish(struct hash_session *session, uint8_t *hash, size_t hash_length)
+{
+	uint8_t digest[64];
+	int ret = -EINVAL;
+
+	if (hash_length < hash_digest_length(session->algo))
+		return -EINVAL;
+
+#if defined(CONFIG_MBEDTLS)
+	switch (session->algo) {
+#if defined(MBEDTLS_SHA1_C)
+	case HASH_SHA1:
+		ret = mbedtls_sha1_finish(&session->sw.sha1, digest);
+		break;
+#endif
+#if defined(MBEDTLS_SHA256_C)
+	case HASH_SHA256:
+		ret = mbedtls_sha256_finish(&session->sw.sha256, digest);
+		break;
+#endif
+#if defined(MBEDTLS_SHA512_C)
+	case HASH_SHA384:
+	case HASH_SHA512:
+		ret = mbedtls_sha512_finish(&session->sw.sha512, digest);
+		break;
+#endif
+	default:
+		break;
+	}
+#endif
+	if (!ret)
+		memcpy(hash, digest, hash_digest_length(session->algo));
 
-static struct hash_params hashParams;	// hash internal parameters
+	return ret;
+}
+
+static void hash_sw_free(struct hash_session *session)
+{
+#if defined(CONFIG_MBEDTLS)
+	switch (session->algo) {
+#if defined(MBEDTLS_SHA1_C)
+	case HASH_SHA1:
+		mbedtls_sha1_free(&session->sw.sha1);
+		break;
+#endif
+#if defined(MBEDTLS_SHA256_C)
+	case HASH_SHA256:
+		mbedtls_sha256_free(&session->sw.sha256);
+		break;
+#endif
+#if defined(MBEDTLS_SHA512_C)
+	case HASH_SHA384:
+	case HASH_SHA512:
+		mbedtls_sha512_free(&session->sw.sha512);
+		break;
+#endif
+	default:
+		break;
+	}
+#endif
+	ARG_UNUSED(session);
+}
+
+static void hash_session_release(struct hash_session *session)
+{
+	const struct device *dev = device_get_binding(HASH_DRV_NAME); // retrieves hash driver device info
+
+	k_mutex_lock(&hash_session_mutex, K_FOREVER);
+	if (session->hw) {
+		hash_free_session(dev, &session->params.ctx); // free hash engine
+		hash_hw_owner = NULL;
+		hash_engine_hw_release();
+	} else {
+		hash_sw_free(session);
+	}
+	memset(session, 0, sizeof(*session));
+	k_mutex_unlock(&hash_session_mutex);
+	k_sem_give(&hash_session_free_sem);
+}
+
+/**
+ * @brief Open a hash session.
+ *
+ * The session runs on the hash engine when it is free, otherwise it is computed in software so
+ * that independent hash operations never have to wait for each other. When every pool entry is
+ * open, this waits up to CONFIG_HASH_SESSION_POOL_TIMEOUT_MS for another thread to close one.
+ * Every session MUST be closed by hash_engine_session_finish or hash_engine_session_cancel.
+ *
+ * @param algo hash algorithm as SHA1, SHA256, SHA384, SHA512
+ * @param session output session handle
+ *
+ * @return 0 if the session was opened or an error code.
+ */
+int hash_engine_session_start(enum hash_algo algo, struct hash_session **session)
+{
+	const struct device *dev = device_get_binding(HASH_DRV_NAME); // retrieves hash driver device info
+	struct hash_session *entry = NULL;
+	size_t i;
+	int ret;
+
+	if (session == NULL)
+		return -EINVAL;
+
+	if (k_sem_take(&hash_session_free_sem, K_MSEC(CONFIG_HASH_SESSION_POOL_TIMEOUT_MS)))
+		return -ENOMEM;
+
+	k_mutex_lock(&hash_session_mutex, K_FOREVER);
+	for (i = 0; i < ARRAY_SIZE(hash_session_pool); i++) {
+		if (!hash_session_pool[i].in_use) {
+			entry = &hash_session_pool[i];
+			break;
+		}
+	}
+
+	if (entry == NULL) {
+		k_mutex_unlock(&hash_session_mutex);
+		k_sem_give(&hash_session_free_sem);
+		return -ENOMEM;
+	}
+
+	memset(entry, 0, sizeof(*entry));
+	entry->algo = algo;
+	ret = -EBUSY;
+	if (dev && hash_engine_hw_try_acquire()) {
+		ret = hash_begin_session(dev, &entry->params.ctx, algo); // initializes hash engine
+		if (!ret) {
+			entry->hw = true;
+			entry->params.sessionReady = 1;
+			hash_hw_owner = entry;
+		} else {
+			hash_engine_hw_release();
+		}
+	}
+
+	if (ret)
+		ret = hash_sw_start(entry, algo);
+
+	if (!ret) {
+		entry->in_use = true;
+		*session = entry;
+	}
+	k_mutex_unlock(&hash_session_mutex);
+
+	if (ret)
+		k_sem_give(&hash_session_free_sem);
+
+	return ret;
+}
+
+/**
+ * @brief Add a block of data to a hash session.
+ */
+int hash_engine_session_update(struct hash_session *session, const uint8_t *data, size_t length)
+{
+	if (session == NULL || !session->in_use)
+		return -EINVAL;
+
+	if (!session->hw)
+		return hash_sw_update(session, data, length);
+
+	session->params.pkt.in_buf = (uint8_t *)data; // plaint text info
+	session->params.pkt.in_len = length; // plaint text size
+
+	return hash_update(&session->params.ctx, &session->params.pkt); // update plaint text into hash engine
+}
+
+/**
+ * @brief Complete a hash session, get the digest and close the session.
+ */
+int hash_engine_session_finish(struct hash_session *session, uint8_t *hash, size_t hash_length)
+{
+	int ret;
+
+	if (session == NULL || !session->in_use)
+		return -EINVAL;
+
+	if (session->hw) {
+		session->params.pkt.out_buf = hash; // hash value and this will updated by hash engine
+		session->params.pkt.out_buf_max = hash_length; //hash size
+		ret = hash_final(&session->params.ctx, &session->params.pkt); // final setup hash engine
+	} else {
+		ret = hash_sw_finish(session, hash, hash_length);
+	}
+
+	hash_session_release(session);
+
+	return ret;
+}
+
+/**
+ * @brief Close a hash session without getting the digest.
+ */
+void hash_engine_session_cancel(struct hash_session *session)
+{
+	if (session == NULL || !session->in_use)
+		return;
+
+	hash_session_release(session);
+}
 
 /**
  * @brief Calculate a hash on a complete set of data.
@@ -26,39 +337,31 @@ static struct hash_params hashParams;	// hash internal parameters
  */
 int hash_engine_sha_calculate(enum hash_algo algo, const uint8_t *data, size_t length, uint8_t *hash, size_t hash_length)
 {
-	const struct device *dev; // hash engine driver info
+	struct hash_session *session;
 	int ret;
 
-	dev = device_get_binding(HASH_DRV_NAME); // retrieves hash driver device info
-
-	hashParams.pkt.in_buf = (uint8_t *)data; //plaint text info
-	hashParams.pkt.in_len = length; // plaint text size
-	hashParams.pkt.out_buf = hash; // hash value and this will updated by hash engine
-	hashParams.pkt.out_buf_max = hash_length; // hash length
-
-	if (hashParams.sessionReady)
-		ret = 0; // hash engine session is ready
-	else
-		ret = hash_begin_session(dev, &hashParams.ctx, algo); // initializes hash engine session
+	ret = hash_engine_session_start(algo, &session);
+	if (ret)
+		return ret;
 
-	if (!ret) { // success to initializes hash engine
-		ret = hash_update(&hashParams.ctx, &hashParams.pkt);  // update plaint text into hash engine
-
-		if (!ret) // success to update hash engine
-			ret = hash_final(&hashParams.ctx, &hashParams.pkt); // final setup hash engine
+	ret = hash_engine_session_update(session, data, length);
+	if (ret) {
+		hash_engine_session_cancel(session);
+		return ret;
 	}
 
-	hash_free_session(dev, &hashParams.ctx); // free hash engine
-	return ret;
+	return hash_engine_session_finish(session, hash, hash_length);
 }
 
 /**
  * @brief Configure the hash engine to process independent blocks of data to calculate a hash
  * the aggregated data.
  *
- * Calling this function will reset any active hashing operation.
+ * Calling this function will reset any active hashing operation started by this function.
  *
- * Every call to start MUST be followed by either a call to finish or cancel.
+ * Every call to start MUST be followed by either a call to finish or cancel from the same
+ * thread. The sequence is held by the calling thread until then, other threads calling start
+ * wait for it.
  *
  * @param algo hash algorithm as SHA1, SHA256, SHA384, SHA512
  *
@@ -66,15 +369,18 @@ int hash_engine_sha_calculate(enum hash_algo algo, const uint8_t *data, size_t l
  */
 int hash_engine_start(enum hash_algo algo)
 {
-	const struct device *dev;	// hash engine driver
 	int ret;
 
-	memset(&hashParams, 0, sizeof(hashParams)); // clear all the hash internal parameters
-	dev = device_get_binding(HASH_DRV_NAME); // retrieves hash driver device info
-	ret = hash_begin_session(dev, &hashParams.ctx, algo); // initializes hash engine
+	k_mutex_lock(&hash_legacy_mutex, K_FOREVER);
+	// Drop a sequence this thread left open, together with the lock it held
+	hash_engine_cancel();
+
+	ret = hash_engine_session_start(algo, &legacy_session);
+	if (ret) {
+		legacy_session = NULL;
+		k_mutex_unlock(&hash_legacy_mutex);
+	}
 
-	if (!ret)
-		hashParams.sessionReady = 1; // hash engine session is ready
 	return ret;
 }
 
@@ -88,20 +394,18 @@ int hash_engine_start(enum hash_algo algo)
  */
 int hash_engine_update(const uint8_t *data, size_t length)
 {
-	int status; //hash operation status
+	int ret;
 
-	hashParams.pkt.in_buf = (uint8_t *)data; // plaint text info
-	hashParams.pkt.in_len = length; // plaint text size
-	status = hash_update(&hashParams.ctx, &hashParams.pkt); // update plaint text into hash engine
-	return status;
+	k_mutex_lock(&hash_legacy_mutex, K_FOREVER);
+	ret = hash_engine_session_update(legacy_session, data, length);
+	k_mutex_unlock(&hash_legacy_mutex);
+
+	return ret;
 }
 
 /**
  * @brief Complete the current hash operation and get the calculated digest.
  *
- * If a call to finish fails, finish MUST be called until it succeeds or the operation can be
- * terminated with a call to cancel.
- *
  * @param hash The buffer to hold the completed hash.
  * @param hash_length The length of the hash buffer.
  *
@@ -109,14 +413,18 @@ int hash_engine_update(const uint8_t *data, size_t length)
  */
 int hash_engine_finish(uint8_t *hash, size_t hash_length)
 {
-	const struct device *dev = device_get_binding(HASH_DRV_NAME); // retrieves hash driver device info
+	struct hash_session *session;
 	int ret;
 
-	hashParams.pkt.out_buf = hash; // hash value and this will updated by hash engine
-	hashParams.pkt.out_buf_max = hash_length; //hash size
-	hashParams.sessionReady = 0; // clear as hash engine session as expired, this should initialize again
-	ret = hash_final(&hashParams.ctx, &hashParams.pkt); // final setup hash engine
-	hash_free_session(dev, &hashParams.ctx); // free hash engine
+	k_mutex_lock(&hash_legacy_mutex, K_FOREVER);
+	session = legacy_session;
+	legacy_session = NULL;
+	ret = hash_engine_session_finish(session, hash, hash_length);
+	// Release the sequence taken by hash_engine_start
+	if (session)
+		k_mutex_unlock(&hash_legacy_mutex);
+	k_mutex_unlock(&hash_legacy_mutex);
+
 	return ret;
 }
 
@@ -128,10 +436,16 @@ int hash_engine_finish(uint8_t *hash, size_t hash_length)
  */
 void hash_engine_cancel(void)
 {
-	const struct device *dev = device_get_binding(HASH_DRV_NAME); // retrieves hash driver device info
-
-	hashParams.sessionReady = 0; // clear as hash engine session as expired, this should initialize again
-	hash_free_session(dev, &hashParams.ctx); // free hash engine
+	struct hash_session *session;
+
+	k_mutex_lock(&hash_legacy_mutex, K_FOREVER);
+	session = legacy_session;
+	legacy_session = NULL;
+	hash_engine_session_cancel(session);
+	// Release the sequence taken by hash_engine_start
+	if (session)
+		k_mutex_unlock(&hash_legacy_mutex);
+	k_mutex_unlock(&hash_legacy_mutex);
 }
 
 #if ZEPHYR_HASH_API_MIDLEYER_TEST_SUPPORT
@@ -240,13 +554,6 @@ static int hash_test_calculate_sha(void)
 	printk("\n%s :\n", __func__);
 
 	for (size_t i = 0; i < ARRAY_SIZE(HASH_TEST_CAL_SHA_INFO); i++) { //hmacLength = hash length
-		status = hash_engine_start(HASH_TEST_CAL_SHA_INFO[i].shaAlgo);
-		if (status) {
-			printk(" X hash_engine_start failed !\n");
-			failure = 1;
-			continue;
-		}
-
 		status = hash_engine_sha_calculate(HASH_TEST_CAL_SHA_INFO[i].shaAlgo,
 						HASH_TEST_CAL_SHA_INFO[i].message, HASH_TEST_CAL_SHA_INFO[i].messageSize,
 						hash, HASH_TEST_CAL_SHA_INFO[i].hmacLength);
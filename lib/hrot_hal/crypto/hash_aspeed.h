@@ -48,6 +48,13 @@ typedef struct hash_params {
 void hash_engine_function_test(void);     // hash functions testing
 #endif
 
+struct hash_session;
+
+int hash_engine_session_start(enum hash_algo algo, struct hash_session **session);
+int hash_engine_session_update(struct hash_session *session, const uint8_t *data, size_t length);
+int hash_engine_session_finish(struct hash_session *session, uint8_t *hash, size_t hash_length);
+void hash_engine_session_cancel(struct hash_session *session);
+
 int hash_engine_sha_calculate(enum hash_algo algo, const uint8_t *data, size_t length, uint8_t *hash, size_t hash_length);
 int hash_engine_start(enum hash_algo algo);
 int hash_engine_update(const uint8_t *data, size_t length);
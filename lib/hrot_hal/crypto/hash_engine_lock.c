@@ -0,0 +1,27 @@
+/*
+ * Copyright (c) 2023 ASPEED Technology Inc.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <zephyr.h>
+#include <sys/atomic.h>
+#include "hash_engine_lock.h"
+
+static atomic_t hash_engine_hw_owned;
+
+/**
+ * @brief Take the hash engine if no other session has it open.
+ *
+ * @return true if the caller now owns the engine and must release it with
+ * hash_engine_hw_release() once its session is freed.
+ */
+bool hash_engine_hw_try_acquire(void)
+{
+	return atomic_cas(&hash_engine_hw_owned, 0, 1);
+}
+
+void hash_engine_hw_release(void)
+{
+	atomic_clear(&hash_engine_hw_owned);
+}
@@ -32,22 +32,178 @@ static char *Flash_Devices_List[6] = {
 	"fmc_cs1"
 };
 
+/* Flash_Devices_List holds two chip selects per SPI controller: spi1, spi2 and fmc */
+#define FLASH_CTRL_COUNT		(ARRAY_SIZE(Flash_Devices_List) / 2)
+#define FLASH_DEV_TO_CTRL(idx)		((idx) / 2)
+
 #if defined(CONFIG_SPI_DMA_SUPPORT_ASPEED) || defined(CONFIG_SPI_WRITE_DMA_SUPPORT_ASPEED)
-struct k_mutex flash_rw_mutex;
+/* Bounce buffers are partitioned per controller so that BMC, PCH and ROT traffic never
+ * serialize on each other, only on the bus they actually share.
+ */
+static struct k_mutex flash_rw_mutex[FLASH_CTRL_COUNT];
 static bool mutex_init = false;
-static uint8_t flash_rw_buf[16384] NON_CACHED_BSS_ALIGN16;
+static uint8_t flash_rw_buf[FLASH_CTRL_COUNT][CONFIG_FLASH_RW_BUF_SIZE] NON_CACHED_BSS_ALIGN16;
+static uint8_t flash_dma_pool[CONFIG_FLASH_DMA_BUF_POOL_SIZE] NON_CACHED_BSS_ALIGN16;
+static struct k_heap flash_dma_heap;
 #endif
 
 #if defined(CONFIG_SPI_DMA_SUPPORT_ASPEED) || defined(CONFIG_SPI_WRITE_DMA_SUPPORT_ASPEED)
 void init_flash_rw_buf_mutex(void)
 {
+	uint8_t ctrl;
+
 	if (!mutex_init) {
-		k_mutex_init(&flash_rw_mutex);
+		for (ctrl = 0; ctrl < FLASH_CTRL_COUNT; ctrl++)
+			k_mutex_init(&flash_rw_mutex[ctrl]);
+		k_heap_init(&flash_dma_heap, flash_dma_pool, sizeof(flash_dma_pool));
 		mutex_init = true;
 	}
 }
 #endif
 
+/**
+ * @brief Check whether a buffer can be handed to the SPI DMA engine as is.
+ *
+ * The buffer has to be 4-byte aligned and fully located in non-cached SRAM.
+ *
+ * @param buf buffer to check
+ * @param length buffer length
+ *
+ * @return true if the buffer does not need to be staged through the bounce buffer.
+ */
+bool flash_is_dma_buf(const void *buf, size_t length)
+{
+#if defined(CONFIG_SPI_DMA_SUPPORT_ASPEED) || defined(CONFIG_SPI_WRITE_DMA_SUPPORT_ASPEED)
+	const uint8_t *ptr = buf;
+
+	if ((uintptr_t)ptr & 0x3)
+		return false;
+
+	return (ptr >= (uint8_t *)NON_CACHED_SRAM_START && ptr < (uint8_t *)NON_CACHED_SRAM_END &&
+		length <= (size_t)((uint8_t *)NON_CACHED_SRAM_END - ptr));
+#else
+	ARG_UNUSED(buf);
+	ARG_UNUSED(length);
+
+	return true;
+#endif
+}
+
+/**
+ * @brief Allocate a buffer that the flash HAL can pass to the SPI DMA engine without staging.
+ *
+ * @param size number of bytes to allocate
+ *
+ * @return pointer to the buffer or NULL if the pool is exhausted.
+ */
+void *flash_dma_buf_alloc(size_t size)
+{
+#if defined(CONFIG_SPI_DMA_SUPPORT_ASPEED) || defined(CONFIG_SPI_WRITE_DMA_SUPPORT_ASPEED)
+	if (!mutex_init)
+		return NULL;
+
+	return k_heap_aligned_alloc(&flash_dma_heap, 16, size, K_NO_WAIT);
+#else
+	return k_malloc(size);
+#endif
+}
+
+void flash_dma_buf_free(void *buf)
+{
+	if (buf == NULL)
+		return;
+
+#if defined(CONFIG_SPI_DMA_SUPPORT_ASPEED) || defined(CONFIG_SPI_WRITE_DMA_SUPPORT_ASPEED)
+	k_heap_free(&flash_dma_heap, buf);
+#else
+	k_free(buf);
+#endif
+}
+
+static int flash_dev_read(uint8_t ctrl, const struct device *dev, uint32_t address,
+		uint32_t data_length, uint8_t *data)
+{
+#if defined(CONFIG_SPI_DMA_SUPPORT_ASPEED)
+	uint8_t *bounce = flash_rw_buf[ctrl];
+	uint32_t len;
+	int ret = 0;
+
+	if (flash_is_dma_buf(data, data_length))
+		return flash_read(dev, address, data, data_length);
+
+	if (k_mutex_lock(&flash_rw_mutex[ctrl], K_MSEC(1000)))
+		return -1;
+
+	while (data_length && !ret) {
+		len = MIN(data_length, CONFIG_FLASH_RW_BUF_SIZE);
+		ret = flash_read(dev, address, bounce, len);
+		if (ret)
+			break;
+		memcpy(data, bounce, len);
+		address += len;
+		data += len;
+		data_length -= len;
+	}
+
+	k_mutex_unlock(&flash_rw_mutex[ctrl]);
+
+	return ret;
+#else
+	ARG_UNUSED(ctrl);
+
+	return flash_read(dev, address, data, data_length);
+#endif
+}
+
+static int flash_dev_write(uint8_t ctrl, const struct device *dev, uint32_t address,
+		uint32_t data_length, uint8_t *data)
+{
+#if defined(CONFIG_SPI_DMA_WRITE_SUPPORT_ASPEED)
+	uint8_t *bounce = flash_rw_buf[ctrl];
+	uint32_t len;
+	int ret = 0;
+
+	if (flash_is_dma_buf(data, data_length))
+		return flash_write(dev, address, data, data_length);
+
+	if (k_mutex_lock(&flash_rw_mutex[ctrl], K_MSEC(1000)))
+		return -1;
+
+	while (data_length && !ret) {
+		len = MIN(data_length, CONFIG_FLASH_RW_BUF_SIZE);
+		memcpy(bounce, data, len);
+		ret = flash_write(dev, address, bounce, len);
+		address += len;
+		data += len;
+		data_length -= len;
+	}
+
+	k_mutex_unlock(&flash_rw_mutex[ctrl]);
+
+	return ret;
+#else
+	ARG_UNUSED(ctrl);
+
+	return flash_write(dev, address, data, data_length);
+#endif
+}
+
+/* Device handles resolved once by init_flash_dev_table(), indexed by device id */
+static const struct device *flash_dev_table[ARRAY_SIZE(Flash_Devices_List)];
+static uint32_t flash_dev_size_table[ARRAY_SIZE(Flash_Devices_List)];
+/* Serializes filling and refreshing the handle tables, lookups of filled entries are lockless */
+static K_MUTEX_DEFINE(flash_dev_table_mutex);
+
+#define ROT_REGION_COUNT (ROT_EXT_CPLD_RC - ROT_INTERNAL_ACTIVE + 1)
+
+struct rot_region_handle {
+	const struct flash_area *fa;
+	const struct device *dev;
+	uint8_t ctrl;
+};
+
+static struct rot_region_handle rot_region_table[ROT_REGION_COUNT];
+
 int get_rot_region(uint8_t device_id, const struct flash_area **fa);
 
 int BMC_PCH_SPI_Command(struct pspi_flash *flash, struct pflash_xfer *xfer)
@@ -108,6 +264,9 @@ int FMC_SPI_Command(struct pspi_flash *flash, struct pflash_xfer *xfer)
 	case SPI_APP_CMD_GET_FLASH_SIZE:
 		return rot_get_region_size(DeviceId);
 	break;
+	case SPI_APP_CMD_GET_FLASH_BLOCK_SIZE:
+		return get_block_erase_size(DeviceId);
+	break;
 	case MIDLEY_FLASH_CMD_WREN:
 		ret = 0;	// bypass as write enabled
 	break;
@@ -152,38 +311,34 @@ int SPI_Command_Xfer(struct pspi_flash *flash, struct pflash_xfer *xfer)
 	return ret;
 }
 
-int get_flash_dev(uint8_t device_id, uint32_t *address, const struct device **dev)
+static const struct device *lookup_flash_dev(uint8_t device_id)
 {
-	uint32_t flash_sz = 0;
+	const struct device *dev;
 
-	*dev = device_get_binding(Flash_Devices_List[device_id]);
-	if (*dev == NULL)
-		return -1;
+	if (device_id >= ARRAY_SIZE(Flash_Devices_List))
+		return NULL;
 
-#if defined(CONFIG_BMC_DUAL_FLASH)
-	if (device_id == BMC_SPI) {
-		flash_sz = flash_get_flash_size(*dev);
-		if (*address >= flash_sz) {
-			device_id += 1;
-			*address -= flash_sz;
-			*dev = device_get_binding(Flash_Devices_List[device_id]);
-		}
-	}
-#endif
-#if defined(CONFIG_CPU_DUAL_FLASH)
-	if (device_id == PCH_SPI) {
-		flash_sz = flash_get_flash_size(*dev);
-		if (*address >= flash_sz) {
-			device_id += 1;
-			*address -= flash_sz;
-			*dev = device_get_binding(Flash_Devices_List[device_id]);
+	dev = flash_dev_table[device_id];
+	if (dev)
+		return dev;
+
+	k_mutex_lock(&flash_dev_table_mutex, K_FOREVER);
+	dev = flash_dev_table[device_id];
+	if (dev == NULL) {
+		dev = device_get_binding(Flash_Devices_List[device_id]);
+		if (dev) {
+			// Publish the handle only once its size is valid
+			flash_dev_size_table[device_id] = flash_get_flash_size(dev);
+			compiler_barrier();
+			flash_dev_table[device_id] = dev;
 		}
 	}
-#endif
-	return 0;
+	k_mutex_unlock(&flash_dev_table_mutex);
+
+	return dev;
 }
 
-int get_rot_region(uint8_t device_id, const struct flash_area **fa)
+static int open_rot_region(uint8_t device_id, const struct flash_area **fa)
 {
 	int ret = 0;
 
@@ -229,8 +384,269 @@ int get_rot_region(uint8_t device_id, const struct flash_area **fa)
 	return ret;
 }
 
+static uint8_t rot_region_ctrl(const struct flash_area *fa)
+{
+	uint8_t idx;
+
+	for (idx = 0; idx < ARRAY_SIZE(Flash_Devices_List); idx++) {
+		if (!strcmp(fa->fa_dev_name, Flash_Devices_List[idx]))
+			return FLASH_DEV_TO_CTRL(idx);
+	}
+
+	return FLASH_DEV_TO_CTRL(ROT_SPI);
+}
+
+static struct rot_region_handle *lookup_rot_region(uint8_t device_id)
+{
+	struct rot_region_handle *region;
+	const struct flash_area *fa;
+
+	if (device_id < ROT_INTERNAL_ACTIVE || device_id > ROT_EXT_CPLD_RC)
+		return NULL;
+
+	region = &rot_region_table[device_id - ROT_INTERNAL_ACTIVE];
+	if (region->fa)
+		return region;
+
+	k_mutex_lock(&flash_dev_table_mutex, K_FOREVER);
+	if (region->fa == NULL) {
+		if (open_rot_region(device_id, &fa)) {
+			region = NULL;
+		} else {
+			region->dev = device_get_binding(fa->fa_dev_name);
+			if (region->dev == NULL) {
+				region = NULL;
+			} else {
+				// Publish the area last, a non NULL fa marks the entry as complete
+				region->ctrl = rot_region_ctrl(fa);
+				compiler_barrier();
+				region->fa = fa;
+			}
+		}
+	}
+	k_mutex_unlock(&flash_dev_table_mutex);
+
+	return region;
+}
+
+static bool rot_region_in_bounds(const struct flash_area *fa, uint32_t address, uint32_t length)
+{
+	return (address <= fa->fa_size) && (length <= fa->fa_size - address);
+}
+
+/**
+ * @brief Resolve the SPI flash device and ROT flash area handles.
+ *
+ * All bmc_pch_* and rot_* accessors use the cached handles. Re-initialize flash devices with
+ * flash_re_init() so that their cached size is refreshed.
+ */
+void init_flash_dev_table(void)
+{
+	uint8_t device_id;
+
+	k_mutex_lock(&flash_dev_table_mutex, K_FOREVER);
+	memset(flash_dev_table, 0, sizeof(flash_dev_table));
+	memset(flash_dev_size_table, 0, sizeof(flash_dev_size_table));
+	memset(rot_region_table, 0, sizeof(rot_region_table));
+	k_mutex_unlock(&flash_dev_table_mutex);
+
+	for (device_id = 0; device_id < ARRAY_SIZE(Flash_Devices_List); device_id++) {
+		if (lookup_flash_dev(device_id) == NULL)
+			LOG_DBG("Flash device %s is not bound", Flash_Devices_List[device_id]);
+	}
+
+	for (device_id = ROT_INTERNAL_ACTIVE; device_id <= ROT_EXT_CPLD_RC; device_id++)
+		lookup_rot_region(device_id);
+}
+
+/**
+ * @brief Re-initialize a SPI flash device and refresh its cached size.
+ *
+ * @param dev flash device
+ *
+ * @return the result of spi_nor_re_init().
+ */
+int flash_re_init(const struct device *dev)
+{
+	uint8_t device_id;
+	int ret;
+
+	ret = spi_nor_re_init(dev);
+
+	k_mutex_lock(&flash_dev_table_mutex, K_FOREVER);
+	for (device_id = 0; device_id < ARRAY_SIZE(Flash_Devices_List); device_id++) {
+		if (flash_dev_table[device_id] == dev)
+			flash_dev_size_table[device_id] = flash_get_flash_size(dev);
+	}
+	k_mutex_unlock(&flash_dev_table_mutex);
+
+	return ret;
+}
+
+int get_flash_dev(uint8_t device_id, uint32_t *address, const struct device **dev)
+{
+	*dev = lookup_flash_dev(device_id);
+	if (*dev == NULL)
+		return -1;
+
+#if defined(CONFIG_BMC_DUAL_FLASH)
+	if (device_id == BMC_SPI) {
+		if (*address >= flash_dev_size_table[device_id]) {
+			*address -= flash_dev_size_table[device_id];
+			*dev = lookup_flash_dev(device_id + 1);
+		}
+	}
+#endif
+#if defined(CONFIG_CPU_DUAL_FLASH)
+	if (device_id == PCH_SPI) {
+		if (*address >= flash_dev_size_table[device_id]) {
+			*address -= flash_dev_size_table[device_id];
+			*dev = lookup_flash_dev(device_id + 1);
+		}
+	}
+#endif
+	if (*dev == NULL)
+		return -1;
+
+	return 0;
+}
+
+int get_rot_region(uint8_t device_id, const struct flash_area **fa)
+{
+	struct rot_region_handle *region = lookup_rot_region(device_id);
+
+	if (region == NULL)
+		return -1;
+
+	*fa = region->fa;
+
+	return 0;
+}
+
+#if defined(CONFIG_FLASH_STATS)
+static struct flash_op_stats flash_stats[FLASH_STATS_DEV_COUNT][FLASH_STATS_OP_COUNT];
+static struct k_spinlock flash_stats_lock;
+
+/* Longer operations are timed in ms, the 32-bit cycle counter wraps after about 21 s at 200 MHz */
+#define FLASH_STATS_CYCLE_MAX_MS	1000
+
+/* Uptime in ms in the upper half, hardware cycles in the lower half */
+static inline uint64_t flash_stats_begin(void)
+{
+	return ((uint64_t)k_uptime_get_32() << 32) | k_cycle_get_32();
+}
+
+static void flash_stats_end(uint8_t device_id, uint8_t op, uint32_t length, uint64_t start,
+		int ret)
+{
+	uint32_t ms = k_uptime_get_32() - (uint32_t)(start >> 32);
+	uint32_t us = (ms < FLASH_STATS_CYCLE_MAX_MS) ?
+		k_cyc_to_us_floor32(k_cycle_get_32() - (uint32_t)start) :
+		MIN(ms, UINT32_MAX / USEC_PER_MSEC) * USEC_PER_MSEC;
+	uint8_t bucket = us ? MIN(31 - __builtin_clz(us), FLASH_STATS_HIST_BUCKETS - 1) : 0;
+	struct flash_op_stats *stats;
+	k_spinlock_key_t key;
+
+	if (device_id >= FLASH_STATS_DEV_COUNT)
+		return;
+
+	stats = &flash_stats[device_id][op];
+	key = k_spin_lock(&flash_stats_lock);
+	stats->count++;
+	if (ret)
+		stats->errors++;
+	else
+		stats->bytes += length;
+	stats->total_us += us;
+	if (us > stats->max_us)
+		stats->max_us = us;
+	stats->hist[bucket]++;
+	k_spin_unlock(&flash_stats_lock, key);
+}
+
+/**
+ * @brief Get a snapshot of the I/O statistics of one device and operation.
+ *
+ * @param device_id flash device id
+ * @param op FLASH_STATS_READ, FLASH_STATS_WRITE or FLASH_STATS_ERASE
+ * @param stats output snapshot
+ *
+ * @return 0 on success or -1 on invalid arguments.
+ */
+int flash_stats_get(uint8_t device_id, uint8_t op, struct flash_op_stats *stats)
+{
+	k_spinlock_key_t key;
+
+	if (device_id >= FLASH_STATS_DEV_COUNT || op >= FLASH_STATS_OP_COUNT || stats == NULL)
+		return -1;
+
+	key = k_spin_lock(&flash_stats_lock);
+	memcpy(stats, &flash_stats[device_id][op], sizeof(*stats));
+	k_spin_unlock(&flash_stats_lock, key);
+
+	return 0;
+}
+
+void flash_stats_reset(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&flash_stats_lock);
+
+	memset(flash_stats, 0, sizeof(flash_stats));
+	k_spin_unlock(&flash_stats_lock, key);
+}
+#else
+static inline uint64_t flash_stats_begin(void)
+{
+	return 0;
+}
+
+static inline void flash_stats_end(uint8_t device_id, uint8_t op, uint32_t length,
+		uint64_t start, int ret)
+{
+}
+#endif
+
+#if defined(CONFIG_FLASH_WRITE_GENERATION)
+static atomic_t flash_write_gen[FLASH_WRITE_GEN_DEV_COUNT];
+
+/**
+ * @brief Get the write generation of a flash device.
+ *
+ * The generation changes after every write or erase issued through this HAL and whenever the
+ * device is switched between the RoT and the BMC or PCH. Data read while the generation stays the same is
+ * still on flash, so results derived from it, e.g. region hashes, can be reused.
+ *
+ * @param device_id flash device id
+ *
+ * @return the current write generation of the device.
+ */
+uint32_t flash_write_generation_get(uint8_t device_id)
+{
+	if (device_id >= FLASH_WRITE_GEN_DEV_COUNT)
+		return 0;
+
+	return (uint32_t)atomic_get(&flash_write_gen[device_id]);
+}
+
+/**
+ * @brief Invalidate everything derived from the current contents of a flash device.
+ *
+ * Called after the device is written or erased, and at every switch of its SPI monitor mux in
+ * either direction. The BMC or PCH may write the device while it owns it, so anything derived
+ * before the RoT takes the device back must not be reused.
+ *
+ * @param device_id flash device id
+ */
+void flash_write_generation_bump(uint8_t device_id)
+{
+	if (device_id < FLASH_WRITE_GEN_DEV_COUNT)
+		atomic_inc(&flash_write_gen[device_id]);
+}
+#endif
+
 int bmc_pch_flash_read(uint8_t device_id, uint32_t address, uint32_t data_length, uint8_t *data)
 {
+	uint64_t start = flash_stats_begin();
 	const struct device *flash_dev;
 	int ret;
 
@@ -238,51 +654,34 @@ int bmc_pch_flash_read(uint8_t device_id, uint32_t address, uint32_t data_length
 	if (ret)
 		return ret;
 
-#if defined(CONFIG_SPI_DMA_SUPPORT_ASPEED)
-	if (data >= (uint8_t *)NON_CACHED_SRAM_START && data < (uint8_t *)NON_CACHED_SRAM_END) {
-		ret = flash_read(flash_dev, address, data, data_length);
-	} else {
-		if (k_mutex_lock(&flash_rw_mutex, K_MSEC(1000)))
-			return -1;
-		ret = flash_read(flash_dev, address, flash_rw_buf, data_length);
-		memcpy(data, flash_rw_buf, data_length);
-		k_mutex_unlock(&flash_rw_mutex);
-	}
-#else
-	ret = flash_read(flash_dev, address, data, data_length);
-#endif
+	ret = flash_dev_read(FLASH_DEV_TO_CTRL(device_id), flash_dev, address, data_length, data);
+	flash_stats_end(device_id, FLASH_STATS_READ, data_length, start, ret);
 
 	return ret;
 }
 
 int rot_flash_read(uint8_t device_id, uint32_t address, uint32_t data_length, uint8_t *data)
 {
-	int ret = 0;
-	const struct flash_area *fa;
+	struct rot_region_handle *region = lookup_rot_region(device_id);
+	uint64_t start = flash_stats_begin();
+	int ret;
 
-	ret = get_rot_region(device_id, &fa);
-	if (ret)
-		return ret;
+	if (region == NULL)
+		return -1;
 
-#if defined(CONFIG_SPI_DMA_SUPPORT_ASPEED)
-	if (data >= (uint8_t *)NON_CACHED_SRAM_START && data < (uint8_t *)NON_CACHED_SRAM_END) {
-		ret = flash_area_read(fa, address, data, data_length);
-	} else {
-		if (k_mutex_lock(&flash_rw_mutex, K_MSEC(1000)))
-			return -1;
-		ret = flash_area_read(fa, address, flash_rw_buf, data_length);
-		memcpy(data, flash_rw_buf, data_length);
-		k_mutex_unlock(&flash_rw_mutex);
-	}
-#else
-	ret = flash_area_read(fa, address, data, data_length);
-#endif
+	if (!rot_region_in_bounds(region->fa, address, data_length))
+		return -EINVAL;
+
+	ret = flash_dev_read(region->ctrl, region->dev, region->fa->fa_off + address,
+			data_length, data);
+	flash_stats_end(device_id, FLASH_STATS_READ, data_length, start, ret);
 
 	return ret;
 }
 
 int bmc_pch_flash_write(uint8_t device_id, uint32_t address, uint32_t data_length, uint8_t *data)
 {
+	uint64_t start = flash_stats_begin();
 	const struct device *flash_dev;
 	int ret;
 
@@ -290,112 +689,122 @@ int bmc_pch_flash_write(uint8_t device_id, uint32_t address, uint32_t data_lengt
 	if (ret)
 		return ret;
 
-#if defined(CONFIG_SPI_DMA_WRITE_SUPPORT_ASPEED)
-	if (data >= (uint8_t *)NON_CACHED_SRAM_START && data < (uint8_t *)NON_CACHED_SRAM_END) {
-		ret = flash_write(flash_dev, address, data, data_length);
-	} else {
-		if (k_mutex_lock(&flash_rw_mutex, K_MSEC(1000)))
-			return -1;
-		ret = flash_write(flash_dev, address, flash_rw_buf, data_length);
-		memcpy(data, flash_rw_buf, data_length);
-		k_mutex_unlock(&flash_rw_mutex);
-	}
-#else
-	ret = flash_write(flash_dev, address, data, data_length);
-#endif
+	ret = flash_dev_write(FLASH_DEV_TO_CTRL(device_id), flash_dev, address, data_length, data);
+	flash_stats_end(device_id, FLASH_STATS_WRITE, data_length, start, ret);
+	flash_write_generation_bump(device_id);
 
 	return ret;
 }
 
 int rot_flash_write(uint8_t device_id, uint32_t address, uint32_t data_length, uint8_t *data)
 {
-	int ret = 0;
-	const struct flash_area *fa;
+	struct rot_region_handle *region = lookup_rot_region(device_id);
+	uint64_t start = flash_stats_begin();
+	int ret;
 
-	ret = get_rot_region(device_id, &fa);
-	if (ret)
-		return ret;
+	if (region == NULL)
+		return -1;
 
-#if defined(CONFIG_SPI_DMA_WRITE_SUPPORT_ASPEED)
-	if (data >= (uint8_t *)NON_CACHED_SRAM_START && data < (uint8_t *)NON_CACHED_SRAM_END) {
-		ret = flash_area_write(fa, address, data, data_length);
-	} else {
-		if (k_mutex_lock(&flash_rw_mutex, K_MSEC(1000)))
-			return -1;
-		ret = flash_area_write(fa, address, flash_rw_buf, data_length);
-		memcpy(data, flash_rw_buf, data_length);
-		k_mutex_unlock(&flash_rw_mutex);
-	}
-#else
-	ret = flash_area_write(fa, address, data, data_length);
-#endif
+	if (!rot_region_in_bounds(region->fa, address, data_length))
+		return -EINVAL;
+
+	ret = flash_dev_write(region->ctrl, region->dev, region->fa->fa_off + address,
+			data_length, data);
+	flash_stats_end(device_id, FLASH_STATS_WRITE, data_length, start, ret);
+	flash_write_generation_bump(device_id);
 
 	return ret;
 }
 
-int bmc_pch_flash_erase(uint8_t device_id, uint32_t address, uint32_t size, bool sector_erase)
+static uint32_t erase_cmd_size(uint8_t cmd)
+{
+	switch (cmd) {
+	case MIDLEY_FLASH_CMD_4K_ERASE:
+		return SECTOR_SIZE;
+	case MIDLEY_FLASH_CMD_32K_ERASE:
+		return BLOCK_32K_SIZE;
+	case MIDLEY_FLASH_CMD_BLOCK_ERASE:
+		return BLOCK_SIZE;
+	default:
+		return 0;
+	}
+}
+
+/**
+ * @brief Erase a BMC/PCH flash range with the given erase opcode.
+ *
+ * @param device_id BMC_SPI or PCH_SPI
+ * @param address start address, aligned to the erase size of cmd
+ * @param size number of bytes to erase, multiple of the erase size of cmd
+ * @param cmd MIDLEY_FLASH_CMD_4K_ERASE, MIDLEY_FLASH_CMD_32K_ERASE or MIDLEY_FLASH_CMD_BLOCK_ERASE
+ *
+ * @return 0 if the range was erased or an error code.
+ */
+int bmc_pch_flash_erase_by_cmd(uint8_t device_id, uint32_t address, uint32_t size, uint8_t cmd)
 {
+	uint32_t erase_sz = erase_cmd_size(cmd);
+	uint64_t start = flash_stats_begin();
 	const struct device *flash_dev;
-	int ret = get_flash_dev(device_id, &address, &flash_dev);
+	int ret;
+
+	if (erase_sz == 0 || size % erase_sz)
+		return -1;
+
+	ret = get_flash_dev(device_id, &address, &flash_dev);
 	if (ret)
 		return ret;
 
-	if (sector_erase) {
-		if (size % SECTOR_SIZE)
-			return -1;
-		ret = spi_nor_erase_by_cmd(flash_dev, address, size,
-				MIDLEY_FLASH_CMD_4K_ERASE);
-	} else {
-		if (size % BLOCK_SIZE)
-			return -1;
-		ret = spi_nor_erase_by_cmd(flash_dev, address, size,
-				MIDLEY_FLASH_CMD_BLOCK_ERASE);
-	}
+	ret = spi_nor_erase_by_cmd(flash_dev, address, size, cmd);
+	flash_stats_end(device_id, FLASH_STATS_ERASE, size, start, ret);
+	flash_write_generation_bump(device_id);
 
 	return ret;
 }
 
-int rot_flash_erase(uint8_t device_id, uint32_t address, uint32_t size, bool sector_erase)
+int rot_flash_erase_by_cmd(uint8_t device_id, uint32_t address, uint32_t size, uint8_t cmd)
 {
-	const struct flash_area *fa;
-	const struct device *flash_dev;
-	int ret = 0;
+	struct rot_region_handle *region = lookup_rot_region(device_id);
+	uint32_t erase_sz = erase_cmd_size(cmd);
+	uint64_t start = flash_stats_begin();
+	int ret;
 
-	ret = get_rot_region(device_id, &fa);
-	if (ret)
-		return ret;
+	if (region == NULL)
+		return -1;
 
-	flash_dev = device_get_binding(fa->fa_dev_name);
-	if (!flash_dev)
+	if (erase_sz == 0 || size % erase_sz)
 		return -1;
 
-	if (sector_erase) {
-		if (size % SECTOR_SIZE)
-			return -1;
-		ret = spi_nor_erase_by_cmd(flash_dev, fa->fa_off + address, size,
-				MIDLEY_FLASH_CMD_4K_ERASE);
-	} else {
-		if (size % BLOCK_SIZE)
-			return -1;
-		ret = spi_nor_erase_by_cmd(flash_dev, fa->fa_off + address, size,
-				MIDLEY_FLASH_CMD_BLOCK_ERASE);
-	}
+	if (!rot_region_in_bounds(region->fa, address, size))
+		return -EINVAL;
 
+	ret = spi_nor_erase_by_cmd(region->dev, region->fa->fa_off + address, size, cmd);
+	flash_stats_end(device_id, FLASH_STATS_ERASE, size, start, ret);
+	flash_write_generation_bump(device_id);
 
 	return ret;
 }
 
+int bmc_pch_flash_erase(uint8_t device_id, uint32_t address, uint32_t size, bool sector_erase)
+{
+	return bmc_pch_flash_erase_by_cmd(device_id, address, size,
+			sector_erase ? MIDLEY_FLASH_CMD_4K_ERASE : MIDLEY_FLASH_CMD_BLOCK_ERASE);
+}
+
+int rot_flash_erase(uint8_t device_id, uint32_t address, uint32_t size, bool sector_erase)
+{
+	return rot_flash_erase_by_cmd(device_id, address, size,
+			sector_erase ? MIDLEY_FLASH_CMD_4K_ERASE : MIDLEY_FLASH_CMD_BLOCK_ERASE);
+}
+
 int bmc_pch_get_flash_size(uint8_t device_id)
 {
 	const struct device *flash_dev;
-	uint32_t flash_sz;
 	uint32_t address = 0;
 	int ret = get_flash_dev(device_id, &address, &flash_dev);
 	if (ret)
 		return ret;
 
-	flash_sz = flash_get_flash_size(flash_dev);
-	return flash_sz;
+	return flash_dev_size_table[device_id];
 }
 
 int rot_get_region_size(uint8_t device_id)
@@ -410,12 +819,246 @@ int rot_get_region_size(uint8_t device_id)
 	return fa->fa_size;
 }
 
+/**
+ * @brief Check whether a buffer only holds erased (0xFF) bytes.
+ */
+bool flash_buf_is_blank(const uint8_t *buf, size_t length)
+{
+	const uint32_t *word = (const uint32_t *)buf;
+	size_t i;
+
+	if ((uintptr_t)buf & 0x3) {
+		for (i = 0; i < length; i++) {
+			if (buf[i] != 0xff)
+				return false;
+		}
+
+		return true;
+	}
+
+	for (i = 0; i < length / sizeof(uint32_t); i++) {
+		if (word[i] != 0xffffffff)
+			return false;
+	}
+
+	for (i = length & ~0x3; i < length; i++) {
+		if (buf[i] != 0xff)
+			return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief Check whether a flash range is already erased.
+ *
+ * The range is read in sector sized chunks and the scan stops at the first programmed word, so
+ * non blank ranges usually cost a single read.
+ *
+ * @param device_id flash device id
+ * @param address start address
+ * @param length number of bytes to check
+ *
+ * @return true if every byte in the range reads as 0xFF, false otherwise or on read failure.
+ */
+bool flash_is_blank(uint8_t device_id, uint32_t address, uint32_t length)
+{
+	bool blank = true;
+	uint8_t *buf;
+	uint32_t len;
+	int ret;
+
+	buf = flash_dma_buf_alloc(SECTOR_SIZE);
+	if (buf == NULL)
+		return false;
+
+	while (length && blank) {
+		len = MIN(length, SECTOR_SIZE);
+		if (device_id <= PCH_SPI)
+			ret = bmc_pch_flash_read(device_id, address, len, buf);
+		else
+			ret = rot_flash_read(device_id, address, len, buf);
+
+		blank = !ret && flash_buf_is_blank(buf, len);
+		address += len;
+		length -= len;
+	}
+
+	flash_dma_buf_free(buf);
+
+	return blank;
+}
+
+/**
+ * @brief Get the erase size of an erase opcode on the device backing device_id.
+ *
+ * @return erase size in bytes, 0 if the opcode is not supported by the flash part, or a
+ * negative error code.
+ */
+int get_erase_size(uint8_t device_id, uint8_t cmd)
+{
+	struct rot_region_handle *region;
+	const struct device *flash_device;
+
+	if (device_id < ROT_INTERNAL_ACTIVE) {
+		flash_device = lookup_flash_dev(device_id);
+	} else {
+		region = lookup_rot_region(device_id);
+		flash_device = region ? region->dev : NULL;
+	}
+
+	if (flash_device == NULL)
+		return -1;
+
+	return spi_nor_get_erase_sz(flash_device, cmd);
+}
+
 int get_block_erase_size(uint8_t device_id)
 {
-	int block_erase_sz = 0;
-	const struct device *flash_device = device_get_binding(Flash_Devices_List[device_id]);
+	return get_erase_size(device_id, MIDLEY_FLASH_CMD_BLOCK_ERASE);
+}
+
+#if defined(CONFIG_FLASH_ASYNC_REQ)
+/* One worker per SPI controller: requests for devices sharing a controller are executed in
+ * submission order, requests for different controllers run concurrently.
+ */
+K_THREAD_STACK_ARRAY_DEFINE(flash_req_stack, FLASH_CTRL_COUNT, CONFIG_FLASH_ASYNC_REQ_STACK_SIZE);
+static struct k_thread flash_req_thread[FLASH_CTRL_COUNT];
+static struct k_fifo flash_req_fifo[FLASH_CTRL_COUNT];
+static bool flash_req_started = false;
+K_MUTEX_DEFINE(flash_req_start_mutex);
+
+static int flash_req_ctrl(uint8_t device_id)
+{
+	struct rot_region_handle *region;
+
+	if (device_id <= PCH_SPI)
+		return FLASH_DEV_TO_CTRL(device_id);
+
+	region = lookup_rot_region(device_id);
+	if (region == NULL)
+		return -1;
+
+	return region->ctrl;
+}
+
+static int flash_req_execute(struct flash_req *req)
+{
+	bool bmc_pch = req->device_id <= PCH_SPI;
+
+	switch (req->op) {
+	case FLASH_REQ_READ:
+		return bmc_pch ? bmc_pch_flash_read(req->device_id, req->address, req->length, req->data) :
+			rot_flash_read(req->device_id, req->address, req->length, req->data);
+	case FLASH_REQ_WRITE:
+		return bmc_pch ? bmc_pch_flash_write(req->device_id, req->address, req->length, req->data) :
+			rot_flash_write(req->device_id, req->address, req->length, req->data);
+	case FLASH_REQ_ERASE:
+		return bmc_pch ? bmc_pch_flash_erase_by_cmd(req->device_id, req->address, req->length,
+				req->erase_cmd) :
+			rot_flash_erase_by_cmd(req->device_id, req->address, req->length, req->erase_cmd);
+	default:
+		return -EINVAL;
+	}
+}
+
+static void flash_req_worker(void *a, void *b, void *c)
+{
+	struct k_fifo *fifo = a;
+	struct k_poll_signal *signal;
+	struct flash_req *req;
+	int result;
+
+	ARG_UNUSED(b);
+	ARG_UNUSED(c);
+
+	while (1) {
+		req = k_fifo_get(fifo, K_FOREVER);
+		result = flash_req_execute(req);
+
+		// The callback may recycle the request, do not touch it afterwards
+		signal = req->signal;
+		req->result = result;
+		if (req->cb)
+			req->cb(req, result);
+		if (signal)
+			k_poll_signal_raise(signal, result);
+	}
+}
+
+static void flash_req_start_workers(void)
+{
+	uint8_t ctrl;
+
+	k_mutex_lock(&flash_req_start_mutex, K_FOREVER);
+	if (!flash_req_started) {
+		for (ctrl = 0; ctrl < FLASH_CTRL_COUNT; ctrl++) {
+			k_fifo_init(&flash_req_fifo[ctrl]);
+			k_thread_create(&flash_req_thread[ctrl], flash_req_stack[ctrl],
+					K_THREAD_STACK_SIZEOF(flash_req_stack[ctrl]),
+					flash_req_worker, &flash_req_fifo[ctrl], NULL, NULL,
+					CONFIG_FLASH_ASYNC_REQ_THREAD_PRIO, 0, K_NO_WAIT);
+			k_thread_name_set(&flash_req_thread[ctrl], Flash_Devices_List[ctrl * 2]);
+		}
+		flash_req_started = true;
+	}
+	k_mutex_unlock(&flash_req_start_mutex);
+}
+
+/**
+ * @brief Queue a flash request on the worker of the SPI controller backing req->device_id.
+ *
+ * The request is owned by the HAL until it completes. Completion is reported through req->cb,
+ * called from the worker thread, and/or by raising req->signal with the result. The buffer
+ * passed in req->data must stay valid until then. Blocking bmc_pch_* and rot_* calls may be
+ * freely mixed with queued requests.
+ *
+ * @param req request to queue
+ *
+ * @return 0 if the request was queued or an error code.
+ */
+int flash_req_submit(struct flash_req *req)
+{
+	int ctrl;
+
+	if (req == NULL || req->op > FLASH_REQ_ERASE)
+		return -EINVAL;
+
+	ctrl = flash_req_ctrl(req->device_id);
+	if (ctrl < 0)
+		return -ENODEV;
+
+	if (!flash_req_started)
+		flash_req_start_workers();
 
-	block_erase_sz = spi_nor_get_erase_sz(flash_device, MIDLEY_FLASH_CMD_BLOCK_ERASE);
+	if (req->signal)
+		k_poll_signal_reset(req->signal);
+	req->result = -EINPROGRESS;
+	k_fifo_put(&flash_req_fifo[ctrl], req);
 
-	return block_erase_sz;
+	return 0;
 }
+
+/**
+ * @brief Wait for a request submitted with a completion signal.
+ *
+ * @return the request result, or -EAGAIN if it did not complete within timeout.
+ */
+int flash_req_wait(struct flash_req *req, k_timeout_t timeout)
+{
+	struct k_poll_event event;
+	unsigned int signaled;
+	int result;
+
+	if (req == NULL || req->signal == NULL)
+		return -EINVAL;
+
+	k_poll_event_init(&event, K_POLL_TYPE_SIGNAL, K_POLL_MODE_NOTIFY_ONLY, req->signal);
+	if (k_poll(&event, 1, timeout))
+		return -EAGAIN;
+
+	k_poll_signal_check(req->signal, &signaled, &result);
+
+	return result;
+}
+#endif
@@ -9,9 +9,11 @@
 #include <zephyr/types.h>
 #include <stddef.h>
 #include <device.h>
+#include <kernel.h>
 
 #define SECTOR_SIZE 0x1000
 #define BLOCK_SIZE  0x10000
+#define BLOCK_32K_SIZE 0x8000
 
 enum {
 	SPI_APP_CMD_NOOP  = 0x00,				/**< No-op */
@@ -70,6 +72,7 @@ enum {
 	//MIDLEY_FLASH_CMD_ALT_WRSR2 = 0x3e,		/**< Alternate Write status register 2 */
 	//MIDLEY_FLASH_CMD_ALT_RDSR2 = 0x3f,		/**< Alternate Read status register 2 */
 	//MIDLEY_FLASH_CMD_VOLATILE_WREN = 0x50,	/**< Volatile write enabl efor status register 1 */
+	MIDLEY_FLASH_CMD_32K_ERASE = 0x52,			/**< Block erase 32kB */
 	//MIDLEY_FLASH_CMD_SFDP = 0x5a,				/**< Read SFDP registers */
 	//MIDLEY_FLASH_CMD_RSTEN = 0x66,			/**< Reset enable */
 	//MIDLEY_FLASH_CMD_QUAD_READ = 0x6b,		/**< Quad output read */
@@ -321,15 +324,97 @@ struct pspi_flash {
 
 int SPI_Command_Xfer(struct pspi_flash *flash, struct pflash_xfer *xfer);
 
+void init_flash_dev_table(void);
+int flash_re_init(const struct device *dev);
+
 int bmc_pch_flash_read(uint8_t device_id, uint32_t address, uint32_t data_length, uint8_t *data);
 int rot_flash_read(uint8_t device_id, uint32_t address, uint32_t data_length, uint8_t *data);
 int bmc_pch_flash_write(uint8_t device_id, uint32_t address, uint32_t data_length, uint8_t *data);
 int rot_flash_write(uint8_t device_id, uint32_t address, uint32_t data_length, uint8_t *data);
 int bmc_pch_flash_erase(uint8_t device_id, uint32_t address, uint32_t size, bool sector_erase);
 int rot_flash_erase(uint8_t device_id, uint32_t address, uint32_t size, bool sector_erase);
+int bmc_pch_flash_erase_by_cmd(uint8_t device_id, uint32_t address, uint32_t size, uint8_t cmd);
+int rot_flash_erase_by_cmd(uint8_t device_id, uint32_t address, uint32_t size, uint8_t cmd);
 int bmc_pch_get_flash_size(uint8_t device_id);
 int rot_get_region_size(uint8_t device_id);
+bool flash_buf_is_blank(const uint8_t *buf, size_t length);
+bool flash_is_blank(uint8_t device_id, uint32_t address, uint32_t length);
+int get_erase_size(uint8_t device_id, uint8_t cmd);
 int get_block_erase_size(uint8_t device_id);
 #if defined(CONFIG_SPI_DMA_SUPPORT_ASPEED) || defined(CONFIG_SPI_WRITE_DMA_SUPPORT_ASPEED)
 void init_flash_rw_buf_mutex(void);
 #endif
+bool flash_is_dma_buf(const void *buf, size_t length);
+void *flash_dma_buf_alloc(size_t size);
+void flash_dma_buf_free(void *buf);
+
+#if defined(CONFIG_FLASH_ASYNC_REQ)
+enum {
+	FLASH_REQ_READ = 0,
+	FLASH_REQ_WRITE,
+	FLASH_REQ_ERASE,
+};
+
+struct flash_req;
+
+typedef void (*flash_req_cb_t)(struct flash_req *req, int result);
+
+/**
+ * Asynchronous flash request, queued with flash_req_submit().
+ */
+struct flash_req {
+	void *fifo_reserved;			/**< Reserved for the request queue. */
+	uint8_t op;				/**< FLASH_REQ_READ, FLASH_REQ_WRITE or FLASH_REQ_ERASE. */
+	uint8_t device_id;			/**< Target device, BMC_SPI to ROT_EXT_CPLD_RC. */
+	uint8_t erase_cmd;			/**< Erase opcode for FLASH_REQ_ERASE. */
+	uint32_t address;			/**< Start address on the device. */
+	uint32_t length;			/**< Number of bytes to read, write or erase. */
+	uint8_t *data;				/**< Data buffer for read and write requests. */
+	flash_req_cb_t cb;			/**< Optional completion callback, run on the worker thread. */
+	void *user_data;			/**< Caller context for the callback. */
+	struct k_poll_signal *signal;		/**< Optional signal raised with the result. */
+	int result;				/**< -EINPROGRESS until completion, then the result. */
+};
+
+int flash_req_submit(struct flash_req *req);
+int flash_req_wait(struct flash_req *req, k_timeout_t timeout);
+#endif
+
+#if defined(CONFIG_FLASH_WRITE_GENERATION)
+#define FLASH_WRITE_GEN_DEV_COUNT	(ROT_EXT_CPLD_RC + 1)
+
+uint32_t flash_write_generation_get(uint8_t device_id);
+void flash_write_generation_bump(uint8_t device_id);
+#else
+static inline void flash_write_generation_bump(uint8_t device_id)
+{
+}
+#endif
+
+enum {
+	FLASH_STATS_READ = 0,
+	FLASH_STATS_WRITE,
+	FLASH_STATS_ERASE,
+	FLASH_STATS_OP_COUNT,
+};
+
+#if defined(CONFIG_FLASH_STATS)
+#define FLASH_STATS_DEV_COUNT		(ROT_EXT_CPLD_RC + 1)
+/* Bucket n counts operations that took [2^n, 2^(n+1)) us, the last bucket is open ended */
+#define FLASH_STATS_HIST_BUCKETS	20
+
+/**
+ * I/O statistics of one operation type on one flash device.
+ */
+struct flash_op_stats {
+	uint32_t count;				/**< Number of operations. */
+	uint32_t errors;			/**< Number of failed operations. */
+	uint64_t bytes;				/**< Bytes moved by successful operations. */
+	uint64_t total_us;			/**< Accumulated latency. */
+	uint32_t max_us;			/**< Worst latency. */
+	uint32_t hist[FLASH_STATS_HIST_BUCKETS];	/**< log2 latency histogram. */
+};
+
+int flash_stats_get(uint8_t device_id, uint8_t op, struct flash_op_stats *stats);
+void flash_stats_reset(void);
+#endif
@@ -13,6 +13,7 @@
 #include <string.h>
 #include <zephyr.h>
 #include <drivers/gpio.h>
+#include <flash/flash_aspeed.h>
 #include "gpio_aspeed.h"
 
 #define LOG_MODULE_NAME gpio_api
@@ -109,6 +110,7 @@ int BMCBootHold(void)
 	spim_passthrough_config(dev_m, 0, false);
 	/* config spi monitor as master mode */
 	spim_ext_mux_config(dev_m, SPIM_EXT_MUX_ROT);
+	flash_write_generation_bump(BMC_SPI);
 	flash_dev = device_get_binding("spi1_cs0");
 	if (flash_dev) {
 		spi_nor_rst_by_cmd(flash_dev);
@@ -120,6 +122,7 @@ int BMCBootHold(void)
 	spim_passthrough_config(dev_m, 0, false);
 	/* config spi monitor as master mode */
 	spim_ext_mux_config(dev_m, SPIM_EXT_MUX_ROT);
+	flash_write_generation_bump(BMC_SPI);
 	flash_dev = device_get_binding("spi1_cs1");
 	if (flash_dev) {
 		spi_nor_rst_by_cmd(flash_dev);
@@ -148,6 +151,7 @@ int PCHBootHold(void)
 	spim_passthrough_config(dev_m, 0, false);
 	/* config spi monitor as master mode */
 	spim_ext_mux_config(dev_m, SPIM_EXT_MUX_ROT);
+	flash_write_generation_bump(PCH_SPI);
 	flash_dev = device_get_binding("spi2_cs0");
 	if (flash_dev) {
 		spi_nor_rst_by_cmd(flash_dev);
@@ -160,6 +164,7 @@ int PCHBootHold(void)
 	spim_passthrough_config(dev_m, 0, false);
 	/* config spi monitor as master mode */
 	spim_ext_mux_config(dev_m, SPIM_EXT_MUX_ROT);
+	flash_write_generation_bump(PCH_SPI);
 	flash_dev = device_get_binding("spi2_cs1");
 	if (flash_dev) {
 		spi_nor_rst_by_cmd(flash_dev);
@@ -187,6 +192,7 @@ int BMCBootRelease(void)
 	aspeed_spi_monitor_sw_rst(dev_m);
 	/* config spi monitor as monitor mode */
 	spim_ext_mux_config(dev_m, SPIM_EXT_MUX_BMC_PCH);
+	flash_write_generation_bump(BMC_SPI);
 #if defined(CONFIG_BMC_DUAL_FLASH)
 	flash_dev = device_get_binding("spi1_cs1");
 	if (flash_dev) {
@@ -199,6 +205,7 @@ int BMCBootRelease(void)
 	aspeed_spi_monitor_sw_rst(dev_m);
 	/* config spi monitor as monitor mode */
 	spim_ext_mux_config(dev_m, SPIM_EXT_MUX_BMC_PCH);
+	flash_write_generation_bump(BMC_SPI);
 #endif
 	// I3CMNGSelection(true);
 	if (first_time_boot) {
@@ -227,6 +234,7 @@ int PCHBootRelease(void)
 	aspeed_spi_monitor_sw_rst(dev_m);
 	/* config spi monitor as monitor mode */
 	spim_ext_mux_config(dev_m, SPIM_EXT_MUX_BMC_PCH);
+	flash_write_generation_bump(PCH_SPI);
 
 #if defined(CONFIG_CPU_DUAL_FLASH)
 	flash_dev = device_get_binding("spi2_cs1");
@@ -240,6 +248,7 @@ int PCHBootRelease(void)
 	aspeed_spi_monitor_sw_rst(dev_m);
 	/* config spi monitor as monitor mode */
 	spim_ext_mux_config(dev_m, SPIM_EXT_MUX_BMC_PCH);
+	flash_write_generation_bump(PCH_SPI);
 #endif
 
 	RTCRSTControl(false);
@@ -0,0 +1,20 @@
+/*
+ * Copyright (c) 2023 ASPEED Technology Inc.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+/**
+ * Ownership of the ASPEED hash engine.
+ *
+ * The engine cannot save or restore its state, so only one hash session may be open on it at a
+ * time. Every user that opens a session on the Zephyr hash driver, hrot_hal and the libspdm
+ * cryptlib backend, has to own the engine first. Acquiring never waits, a user that does not
+ * get the engine computes the digest in software.
+ */
+bool hash_engine_hw_try_acquire(void);
+void hash_engine_hw_release(void);
@@ -8,6 +8,7 @@
 #include <drivers/spi_nor.h>
 
 #include <kernel.h>
+#include <logging/log.h>
 #include <sys/util.h>
 #include <stdlib.h>
 #include <string.h>
@@ -18,6 +19,7 @@
 #include <flash/flash_wrapper.h>
 #include <flash/flash_aspeed.h>
 
+LOG_MODULE_REGISTER(flash_wrapper, CONFIG_LOG_DEFAULT_LEVEL);
 
 /**
  * Get the size of the flash device.
@@ -142,59 +144,29 @@ int Wrapper_spi_flash_minimum_write_per_page(struct spi_flash *flash, uint32_t *
 int Wrapper_spi_flash_write(struct spi_flash *flash, uint32_t address, const uint8_t *data, size_t length)
 {
 	struct flash_xfer xfer;
-	uint32_t page = FLASH_PAGE_BASE(address);
-	uint32_t next = page + FLASH_PAGE_SIZE;
-	size_t remaining = length;
 	int status = 0;
 	int write_flags = 0, addr_mode = 0;
 
 	if ((flash == NULL)) {
 		return SPI_FLASH_INVALID_ARGUMENT;
 	}
-	// Wrapper_spi_flash_get_device_size(flash, &bytes);
-	// SPI_FLASH_BOUNDS_CHECK (flash->device_size, address, length);
 
-	while ((status == 0) && remaining) {
-		uint32_t end = address + remaining;
-		size_t write_len;
-
-		if (page != FLASH_PAGE_BASE(end)) {
-			write_len = next - address;
-		} else   {
-			write_len = remaining;
-		}
-
-
-		FLASH_XFER_INIT_WRITE(xfer, FLASH_CMD_PP, address, 0, (uint8_t *) data, write_len,
-				      write_flags | addr_mode);
-
-
-		status = SPI_Command_Xfer(flash, &xfer);
-
-		// if (status == 0) {
-		// status = spi_flash_wait_for_write_completion (flash, -1, 1);
-		if (status == 0) {
-			remaining -= write_len;
-			data += write_len;
-			page = next;
-			address = next;
-			next += FLASH_PAGE_SIZE;
-		}
+	if (length == 0) {
+		return 0;
 	}
 
-	length = length - remaining;
+	/* The SPI NOR driver splits the program on page boundaries itself, so the whole buffer is
+	 * handed down in one transfer instead of one transfer per FLASH_PAGE_SIZE. */
+	FLASH_XFER_INIT_WRITE(xfer, FLASH_CMD_PP, address, 0, (uint8_t *) data, length,
+			      write_flags | addr_mode);
 
-	if (length) {
-		if (status != 0) {
-			printk("debug_log_create_entry\n");
-			// debug_log_create_entry (DEBUG_LOG_SEVERITY_ERROR, DEBUG_LOG_COMPONENT_FLASH,
-			// FLASH_LOGGING_INCOMPLETE_WRITE, address, status);
-		}
-		return length;
-	} else   {
+	status = SPI_Command_Xfer(flash, &xfer);
+	if (status != 0) {
+		LOG_ERR("Incomplete flash write at 0x%08x, status %d", address, status);
 		return status;
 	}
 
+	return length;
 }
 
 /**
@@ -207,17 +179,13 @@ int Wrapper_spi_flash_write(struct spi_flash *flash, uint32_t address, const uin
  */
 int Wrapper_spi_flash_get_sector_size(struct spi_flash *flash, uint32_t *bytes)
 {
-	struct flash_xfer xfer;
-
 	if ((flash == NULL) || (bytes == NULL)) {
 		return SPI_FLASH_INVALID_ARGUMENT;
 	}
 
-	xfer.cmd = SPI_APP_CMD_GET_FLASH_SECTOR_SIZE;
-
-
-	*bytes = SPI_Command_Xfer(flash, &xfer);
-
+	// SPI_APP_CMD_GET_FLASH_SECTOR_SIZE shares its opcode with write enable, every
+	// supported part uses 4KB sectors
+	*bytes = SECTOR_SIZE;
 
 	return 0;
 }
@@ -238,7 +206,10 @@ int Wrapper_spi_flash_sector_erase(struct spi_flash *flash, uint32_t sector_addr
 	if (flash == NULL) {
 		return SPI_FLASH_INVALID_ARGUMENT;
 	}
+
 	xfer.cmd = MIDLEY_FLASH_CMD_4K_ERASE;
+	xfer.address = sector_addr & ~(SECTOR_SIZE - 1);
+	xfer.length = SECTOR_SIZE;
 
 	status = SPI_Command_Xfer(flash, &xfer);
 
@@ -284,7 +255,10 @@ int Wrapper_spi_flash_block_erase(struct spi_flash *flash, uint32_t block_addr)
 	if (flash == NULL) {
 		return SPI_FLASH_INVALID_ARGUMENT;
 	}
+
 	xfer.cmd = MIDLEY_FLASH_CMD_BLOCK_ERASE;
+	xfer.address = block_addr & ~(BLOCK_SIZE - 1);
+	xfer.length = BLOCK_SIZE;
 
 	status = SPI_Command_Xfer(flash, &xfer);
 